@@ -0,0 +1,36 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Counts heap allocations to check that a frame doesn't make any
+ */
+
+#ifndef ALLOCATION_AUDIT_H
+#define ALLOCATION_AUDIT_H
+
+#include <cstddef>
+
+using namespace std;
+
+// Once the flock is warmed up a frame should not allocate: every buffer
+// keeps its capacity from the frames before. Built with make AUDIT=1
+// (-DALLOC_AUDIT) every operator new, malloc, calloc, realloc and
+// posix_memalign is counted (the C ones only with glibc), as are the pages
+// mapped by allocatePages, and a frame that allocates anyway stops the
+// program with what it counted. Without it the counts stay 0 and the checks
+// cost nothing.
+
+struct AllocationCount {
+  size_t news;    // operator new and new[]
+  size_t mallocs; // malloc, calloc, realloc, posix_memalign
+  size_t pages;   // large pieces mapped by allocatePages
+};
+
+bool allocationAuditOn();
+AllocationCount allocationCount();
+void notePageAllocation();
+// Stops the program if anything was allocated since the count since
+void expectNoAllocations(AllocationCount const &since, char const *what,
+                         int frame);
+
+#endif // ALLOCATION_AUDIT_H
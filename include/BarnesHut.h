@@ -0,0 +1,54 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Barnes-Hut octree used to approximate gathering between all boids
+ */
+
+#ifndef BARNES_HUT_H
+#define BARNES_HUT_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+
+using namespace std;
+
+// Every cell stores how many boids it holds and their centre of mass. A cell
+// of side s that is further than s / theta from a boid pulls on it as one
+// boid of that weight at the centre of mass, closer cells are opened up.
+// Boids closer than reach already interact in the pair loop, so cells within
+// reach are skipped and cells reaching into it are never taken as one boid.
+// Rebuilt every step, gathering for all boids is then O(N log N).
+
+class BarnesHut {
+public:
+  enum { LEAF_SIZE = 8, MAX_DEPTH = 16 };
+
+  BarnesHut();
+  void build(BoidStore const &boids);
+  Vec3f gather(int i, float theta, float reach, float (*law)(float)) const;
+
+private:
+  struct Cell {
+    Vec3f centre;     // middle of the cube
+    float half;       // half the side length of the cube
+    Vec3f massCentre; // average position of the boids inside
+    int count;        // boids inside
+    int first, last;  // range of m_index for a leaf
+    int child[8];     // -1 where there is no child, all -1 for a leaf
+  };
+
+  int buildCell(int first, int last, Vec3f const &centre, float half,
+                int depth);
+  bool inside(Cell const &cell, Vec3f const &pos) const;
+
+  vector<Vec3f> m_points; // positions by boid
+  vector<int> m_index;    // boids grouped by cell
+  vector<int> m_scratch;  // octant of each boid while grouping
+  vector<int> m_grouped;  // boids in their new order while grouping
+  vector<Cell> m_cells;   // cell 0 is the root
+  mutable vector<int> m_stack;
+};
+
+#endif // BARNES_HUT_H
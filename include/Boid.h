@@ -10,37 +10,31 @@
 
 #include <iostream>
 #include "Vec3f.h"
-#include <vector>
-#include "Mat4f.h"
-#include "OpenGLMatrixTools.h"
+#include "BoidStore.h"
 
 using namespace std;
 
 // Defines the properties of a Boid
+// The state lives in a BoidStore, a Boid is only a handle to one of its
+// entries, so it stays valid as long as the store isn't reordered.
 
 class Boid {
 public:
-  vector<Boid*> Boids;
-  Boid() {};
-  Boid(Vec3f pos);
-  Vec3f getPos();
+  Boid(BoidStore &store, int index);
+  Vec3f getPos() const;
   void setPos(Vec3f newPos);
-  Vec3f getForce();
+  Vec3f getForce() const;
   void setForce(Vec3f newForce);
-  float getMass();
+  float getMass() const;
   void setMass(float newMass);
-  Vec3f getVelocity();
+  Vec3f getVelocity() const;
   void setVelocity(Vec3f newVel);
   void resetForce();
-  Mat4f getOrientation();
-  void setOrientation(Mat4f newOrien);
+  int index() const;
 
 private:
-  Vec3f position;
-  float mass;
-  Vec3f velocity;
-  Vec3f force;
-  Mat4f orientation;
+  BoidStore *m_store;
+  int m_index;
 };
 
 #endif // BOID_H
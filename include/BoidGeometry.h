@@ -0,0 +1,29 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Triangles drawn for the boids, built four boids at a time
+ */
+
+#ifndef BOID_GEOMETRY_H
+#define BOID_GEOMETRY_H
+
+#include "BoidStore.h"
+
+using namespace std;
+
+// Every live boid becomes one triangle of 3 vertices of x y z, written to
+// out one boid after the other. Unoriented, the nose is 0.5 to the left of
+// the boid and the tail 1 to the right and 0.5 up and down, exactly as
+// getBoidGeomPoints always made them. Oriented, the nose points along the
+// velocity and the tail is spread across it, parallel to the xy plane
+// where it can be; a boid that stands still is drawn unoriented.
+// Four boids are worked out at once with SSE and moved into a small block
+// that is then written out with streaming stores, which go past the cache
+// into mapped GL memory. When out isn't 16 byte aligned, normal stores are
+// used instead. The boids past the last full four are written as floats.
+// Returns the number of boids written, 9 floats each.
+
+int boidTriangles(BoidStore &boids, float *out, bool oriented);
+
+#endif // BOID_GEOMETRY_H
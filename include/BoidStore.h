@@ -0,0 +1,252 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Structure of arrays holding the state of every boid
+ */
+
+#ifndef BOID_STORE_H
+#define BOID_STORE_H
+
+#include "Vec3f.h"
+#include "FlockArena.h"
+#include <vector>
+
+using namespace std;
+
+// Boids per tile of the store, 0 keeps every column a single array.
+// Set with make TILE=8 (AVX) or make TILE=16 (AVX-512).
+#ifndef BOID_TILE
+#define BOID_TILE 0
+#endif
+
+// 1 gives every boid its own radii, weights and limits, stored as columns
+// like the rest of its state. Set with make PARAMS=1, with 0 every boid
+// uses the scenario's values and the columns don't exist.
+#ifndef BOID_PARAMS
+#define BOID_PARAMS 0
+#endif
+
+// Each property of the boids is its own array, so the loops over all boids
+// read memory in sequence instead of chasing a pointer per boid.
+// With TILE > 0 the arrays are cut into tiles of TILE boids that are stored
+// one after the other, [x0..x7][y0..y7]...[x8..x15][y8..y15]..., so
+// everything about one boid is within a few cache lines while each property
+// of a tile is still a run of TILE floats. Either way the loops over all
+// boids go through tile(k), TILE_WIDTH boids at a time, and the ones that
+// pick single boids use column(c)[slot(i)].
+// The memory comes out of the store's own arena, each array (or tile)
+// starts on a 64 byte boundary. Clearing the store rewinds the arena
+// without freeing anything, release() or destroying the store gives the
+// memory back.
+// Positions and velocities are double buffered: a step only reads the
+// current ones, writes the next ones and then swaps the two, so the current
+// state never changes while a step is running and nothing is copied.
+// Boids keep their slot until the store is compacted or permuted. A removed
+// boid leaves a dead slot on a free list that the next added boid takes
+// over, so adding and removing are O(1) and only move the arrays when more
+// boids are alive than were reserved.
+
+template <int TILE>
+class BasicBoidStore {
+public:
+  enum { ALIGNMENT = 64, TILE_WIDTH = TILE > 0 ? TILE : 8 };
+  enum Column {
+    PX, PY, PZ, VX, VY, VZ,                               // current state
+    FX, FY, FZ, MASS,
+    NEXT_PX, NEXT_PY, NEXT_PZ, NEXT_VX, NEXT_VY, NEXT_VZ, // being written
+    KEPT_FX, KEPT_FY, KEPT_FZ, // forces kept over several steps
+#if BOID_PARAMS
+    AVOID_RADIUS, COHESION_RADIUS, GATHER_RADIUS, // own parameters
+    AVOID_WEIGHT, COHESION_WEIGHT, GATHER_WEIGHT,
+    MAX_FORCE, MAX_SPEED,
+#endif
+    NUM_COLUMNS
+  };
+
+  // Up to TILE_WIDTH boids next to each other, each property of them is a
+  // run of count() floats
+  class Tile {
+  public:
+    int first() const { return m_first; }
+    int count() const { return m_count; }
+    unsigned char const *alive() const { return m_store->m_alive + m_first; }
+
+    float const *px() const { return field(PX); }
+    float const *py() const { return field(PY); }
+    float const *pz() const { return field(PZ); }
+    float const *vx() const { return field(VX); }
+    float const *vy() const { return field(VY); }
+    float const *vz() const { return field(VZ); }
+    float *nextPx() const { return field(NEXT_PX); }
+    float *nextPy() const { return field(NEXT_PY); }
+    float *nextPz() const { return field(NEXT_PZ); }
+    float *nextVx() const { return field(NEXT_VX); }
+    float *nextVy() const { return field(NEXT_VY); }
+    float *nextVz() const { return field(NEXT_VZ); }
+    float *fx() const { return field(FX); }
+    float *fy() const { return field(FY); }
+    float *fz() const { return field(FZ); }
+    float *mass() const { return field(MASS); }
+    float *field(Column c) const { return m_store->m_col[c] + m_offset; }
+
+  private:
+    friend class BasicBoidStore;
+    Tile(BasicBoidStore *store, int k);
+
+    BasicBoidStore *m_store;
+    int m_first;
+    int m_count;
+    int m_offset; // where the tile starts in every column
+  };
+
+  BasicBoidStore();
+
+  int size() const;
+  int liveCount() const;
+  int deadCount() const;
+  int capacity() const;
+  void reserve(int capacity);
+  void clear();
+  void release();
+  int add(Vec3f const &pos);
+  void remove(int i);
+  bool isAlive(int i) const;
+  unsigned char const *alive() const { return m_alive; }
+  void resetForces();
+  void resetKeptForces();
+  void swap();
+  void permute(int const *order, int count);
+  void compact(vector<int> &order);
+
+  int tileCount() const;
+  Tile tile(int k);
+  static int slot(int i);
+  float const *column(Column c) const { return m_col[c]; }
+  float *column(Column c) { return m_col[c]; }
+
+  Vec3f position(int i) const;
+  void setPosition(int i, Vec3f const &pos);
+  Vec3f velocity(int i) const;
+  void setVelocity(int i, Vec3f const &vel);
+  Vec3f force(int i) const;
+  void setForce(int i, Vec3f const &force);
+  float mass(int i) const;
+  void setMass(int i, float mass);
+
+private:
+  BasicBoidStore(BasicBoidStore const &);
+  BasicBoidStore &operator=(BasicBoidStore const &);
+
+  int m_size;     // slots in use, alive or dead
+  int m_capacity;
+  int m_freeCount; // dead slots waiting on m_free
+  FlockArena m_arena;
+  float *m_block;
+  unsigned char *m_alive;
+  int *m_free;
+  float *m_col[NUM_COLUMNS]; // where boid 0 of each column is
+};
+
+typedef BasicBoidStore<BOID_TILE> BoidStore;
+
+// Where boid i is in every column
+template <int TILE>
+inline int BasicBoidStore<TILE>::slot(int i) {
+  if (TILE == 0) {
+    return i;
+  }
+  return (i / TILE) * (TILE * NUM_COLUMNS) + i % TILE;
+}
+
+// Number of slots, loops over the boids have to skip the dead ones
+template <int TILE>
+inline int BasicBoidStore<TILE>::size() const { return m_size; }
+
+template <int TILE>
+inline int BasicBoidStore<TILE>::liveCount() const {
+  return m_size - m_freeCount;
+}
+
+template <int TILE>
+inline int BasicBoidStore<TILE>::deadCount() const { return m_freeCount; }
+
+template <int TILE>
+inline bool BasicBoidStore<TILE>::isAlive(int i) const {
+  return m_alive[i] != 0;
+}
+
+template <int TILE>
+inline int BasicBoidStore<TILE>::capacity() const { return m_capacity; }
+
+template <int TILE>
+inline int BasicBoidStore<TILE>::tileCount() const {
+  return (m_size + TILE_WIDTH - 1) / TILE_WIDTH;
+}
+
+template <int TILE>
+inline typename BasicBoidStore<TILE>::Tile BasicBoidStore<TILE>::tile(int k) {
+  return Tile(this, k);
+}
+
+template <int TILE>
+inline BasicBoidStore<TILE>::Tile::Tile(BasicBoidStore *store, int k) {
+  m_store = store;
+  m_first = k * TILE_WIDTH;
+  m_count = min(int(TILE_WIDTH), store->m_size - m_first);
+  m_offset = slot(m_first);
+}
+
+template <int TILE>
+inline Vec3f BasicBoidStore<TILE>::position(int i) const {
+  int s = slot(i);
+  return Vec3f(m_col[PX][s], m_col[PY][s], m_col[PZ][s]);
+}
+
+template <int TILE>
+inline void BasicBoidStore<TILE>::setPosition(int i, Vec3f const &pos) {
+  int s = slot(i);
+  m_col[PX][s] = pos.x();
+  m_col[PY][s] = pos.y();
+  m_col[PZ][s] = pos.z();
+}
+
+template <int TILE>
+inline Vec3f BasicBoidStore<TILE>::velocity(int i) const {
+  int s = slot(i);
+  return Vec3f(m_col[VX][s], m_col[VY][s], m_col[VZ][s]);
+}
+
+template <int TILE>
+inline void BasicBoidStore<TILE>::setVelocity(int i, Vec3f const &vel) {
+  int s = slot(i);
+  m_col[VX][s] = vel.x();
+  m_col[VY][s] = vel.y();
+  m_col[VZ][s] = vel.z();
+}
+
+template <int TILE>
+inline Vec3f BasicBoidStore<TILE>::force(int i) const {
+  int s = slot(i);
+  return Vec3f(m_col[FX][s], m_col[FY][s], m_col[FZ][s]);
+}
+
+template <int TILE>
+inline void BasicBoidStore<TILE>::setForce(int i, Vec3f const &force) {
+  int s = slot(i);
+  m_col[FX][s] = force.x();
+  m_col[FY][s] = force.y();
+  m_col[FZ][s] = force.z();
+}
+
+template <int TILE>
+inline float BasicBoidStore<TILE>::mass(int i) const {
+  return m_col[MASS][slot(i)];
+}
+
+template <int TILE>
+inline void BasicBoidStore<TILE>::setMass(int i, float mass) {
+  m_col[MASS][slot(i)] = mass;
+}
+
+#endif // BOID_STORE_H
@@ -0,0 +1,32 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Reads the CPU's cache miss counter around a piece of code
+ */
+
+#ifndef CACHE_MISS_COUNTER_H
+#define CACHE_MISS_COUNTER_H
+
+#include <stdint.h>
+
+// Uses perf_event_open on Linux. If the counter can't be opened (other
+// systems, or perf is restricted) available() is false and every reading
+// is 0.
+
+class CacheMissCounter {
+public:
+  CacheMissCounter();
+  ~CacheMissCounter();
+  bool available() const;
+  void start();
+  uint64_t stop(); // misses since start()
+
+private:
+  CacheMissCounter(CacheMissCounter const &);
+  CacheMissCounter &operator=(CacheMissCounter const &);
+
+  int m_fd;
+};
+
+#endif // CACHE_MISS_COUNTER_H
@@ -16,6 +16,7 @@
 #include <iostream>
 
 #include "Vec3f.h"
+#include "Vec3fA.h"
 #include "Mat4f.h"
 #include "Quat4f.h"
 #include "OpenGLMatrixTools.h"
@@ -35,16 +36,17 @@ public:
   void move(Vec3f const &offset);
 
   float focusDistance() const;
-  Vec3f const &position() const;
-  Vec3f const &forward() const;
-  Vec3f const &up() const;
+  Vec3f position() const;
+  Vec3f forward() const;
+  Vec3f up() const;
   Vec3f right() const;
 
 private:
+  // padded, the rotations below are all SSE
   float m_focusDist;
-  Vec3f m_pos;
-  Vec3f m_up;
-  Vec3f m_forward;
+  Vec3fA m_pos;
+  Vec3fA m_up;
+  Vec3fA m_forward;
 };
 
 // INLINE DEFINITIONS //
@@ -53,13 +55,13 @@ inline Camera::Camera(Vec3f const &pos, Vec3f const &forward, Vec3f const &up)
     : m_focusDist(forward.length()), m_pos(pos), m_up(up), m_forward(forward) {}
 
 inline void Camera::rotateAroundFocus(float deltaX, float deltaY) {
-  Vec3f focus = m_pos + m_forward * m_focusDist;
-  Vec3f diff = m_pos - focus;
+  Vec3fA focus = m_pos + m_forward * m_focusDist;
+  Vec3fA diff = m_pos - focus;
 
   rotateAround(diff, m_up, -deltaX);
   m_forward = -(diff.normalized());
 
-  Vec3f bi = m_up ^ m_forward;
+  Vec3fA bi = m_up ^ m_forward;
   bi.normalize();
 
   rotateAround(diff, bi, deltaY);
@@ -70,7 +72,7 @@ inline void Camera::rotateAroundFocus(float deltaX, float deltaY) {
 }
 
 inline void Camera::rotateUpDown(float t) {
-  Vec3f bi = m_up ^ m_forward;
+  Vec3fA bi = m_up ^ m_forward;
   rotateAround(m_forward, bi, t);
 
   m_forward.normalize();
@@ -92,19 +94,23 @@ inline void Camera::rotateRoll(float t) {
 
 inline Mat4f Camera::lookatMatrix() const {
 
-  return LookAtMatrix(m_pos, m_pos + m_forward * m_focusDist, m_up);
+  return LookAtMatrix(m_pos.toVec3f(),
+                      (m_pos + m_forward * m_focusDist).toVec3f(),
+                      m_up.toVec3f());
 }
 
 inline void Camera::move(Vec3f const &offset) {
-  Vec3f bi = m_up ^ m_forward;
+  Vec3fA bi = m_up ^ m_forward;
   bi.normalize();
 
   m_pos += bi * offset.x() + m_up * offset.y() + m_forward * offset.z();
 }
 
 inline float Camera::focusDistance() const { return m_focusDist; }
-inline Vec3f const &Camera::position() const { return m_pos; }
-inline Vec3f const &Camera::forward() const { return m_forward; }
-inline Vec3f const &Camera::up() const { return m_up; }
-inline Vec3f Camera::right() const { return (m_up ^ m_forward).normalized(); }
+inline Vec3f Camera::position() const { return m_pos.toVec3f(); }
+inline Vec3f Camera::forward() const { return m_forward.toVec3f(); }
+inline Vec3f Camera::up() const { return m_up.toVec3f(); }
+inline Vec3f Camera::right() const {
+  return (m_up ^ m_forward).normalized().toVec3f();
+}
 #endif /* defined(____Camera__) */
@@ -0,0 +1,71 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * 16 bit fixed point copy of the boid positions and velocities
+ */
+
+#ifndef COMPACT_BOIDS_H
+#define COMPACT_BOIDS_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+
+using namespace std;
+
+// Every boid stays inside [-range, range], so a coordinate is stored as a
+// short counting steps of range/QUANT_MAX from the origin, and a velocity
+// component as steps of maxSpeed/QUANT_MAX. That is half the bytes of the
+// floats in the store for loops that only read the state, the store keeps
+// the full precision values that get integrated.
+
+class CompactBoids {
+public:
+  enum { QUANT_MAX = 32767 };
+
+  CompactBoids();
+  void encode(BoidStore const &boids, float range, float maxSpeed);
+  void geometry(unsigned char const *alive, vector<short> &out) const;
+  int size() const;
+  float positionStep() const;
+  float velocityStep() const;
+  Vec3f position(int i) const;
+  Vec3f velocity(int i) const;
+
+  short const *qx() const { return m_qx.data(); }
+  short const *qy() const { return m_qy.data(); }
+  short const *qz() const { return m_qz.data(); }
+  short const *qvx() const { return m_qvx.data(); }
+  short const *qvy() const { return m_qvy.data(); }
+  short const *qvz() const { return m_qvz.data(); }
+
+private:
+  static short quantize(float value, float invStep);
+  static short saturate(int q);
+
+  float m_positionStep; // world units per step
+  float m_velocityStep;
+  vector<short> m_qx;
+  vector<short> m_qy;
+  vector<short> m_qz;
+  vector<short> m_qvx;
+  vector<short> m_qvy;
+  vector<short> m_qvz;
+};
+
+inline int CompactBoids::size() const { return int(m_qx.size()); }
+
+inline float CompactBoids::positionStep() const { return m_positionStep; }
+
+inline float CompactBoids::velocityStep() const { return m_velocityStep; }
+
+inline Vec3f CompactBoids::position(int i) const {
+  return Vec3f(m_qx[i], m_qy[i], m_qz[i]) * m_positionStep;
+}
+
+inline Vec3f CompactBoids::velocity(int i) const {
+  return Vec3f(m_qvx[i], m_qvy[i], m_qvz[i]) * m_velocityStep;
+}
+
+#endif // COMPACT_BOIDS_H
@@ -0,0 +1,50 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Block allocator owning the memory of one flock
+ */
+
+#ifndef FLOCK_ARENA_H
+#define FLOCK_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Hands out aligned pieces of a few large blocks by bumping an offset.
+// Pieces are never freed one by one: reset() rewinds to the first block in
+// O(1) and keeps the blocks for the next run, release() gives them all back.
+// The blocks come from allocatePages, so once they are big enough they are
+// on huge pages if the scenario asked for them (see PageAllocator.h).
+
+class FlockArena {
+public:
+  enum { ALIGNMENT = 64, MIN_BLOCK = 64 * 1024 };
+
+  FlockArena();
+  ~FlockArena();
+  void *allocate(size_t bytes);
+  void reset();
+  void release();
+  size_t used() const;
+  size_t reserved() const;
+
+private:
+  FlockArena(FlockArena const &);
+  FlockArena &operator=(FlockArena const &);
+
+  struct Block {
+    char *data;
+    size_t size;
+  };
+
+  vector<Block> m_blocks;
+  size_t m_current; // block being handed out from
+  size_t m_offset;  // first free byte in the current block
+  size_t m_used;    // bytes handed out since the last reset
+  size_t m_reserved;
+};
+
+#endif // FLOCK_ARENA_H
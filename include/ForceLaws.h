@@ -0,0 +1,74 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Avoidance and gathering laws without pow, from tables or polynomials
+ */
+
+#ifndef FORCE_LAWS_H
+#define FORCE_LAWS_H
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// favoid and fgather work out (1-r)^3 (3r+1) and 1/d^2 through pow in double
+// for every pair. Built for a scenario, this gives the same two laws per
+// unit weight another way:
+//   TABLE_LAWS       TABLE_CELLS cells over r in [0, 1] for avoidance and
+//                    over d in [1, gather radius] for gathering, linearly
+//                    interpolated. Gathering further out than the table
+//                    (Barnes-Hut) is worked out exactly.
+//   POLYNOMIAL_LAWS  avoidance expanded to 1 - 6r^2 + 8r^3 - 3r^4, gathering
+//                    as 1 / (d*d), both in float.
+// build() measures how far each law is off the pow version, in units of
+// the weight. POW_LAWS keeps favoid and fgather as they were.
+
+enum ForceLawMode { POW_LAWS = 0, TABLE_LAWS = 1, POLYNOMIAL_LAWS = 2 };
+
+class ForceLaws {
+public:
+  enum { TABLE_CELLS = 1024 };
+
+  ForceLaws();
+  void build(ForceLawMode mode, float gatherRadius);
+  ForceLawMode mode() const { return m_mode; }
+  float avoid(float r) const;          // r is distance / radius, in [0, 1]
+  float gather(float distance) const;  // 1 up to distance 1
+  float avoidError() const { return m_avoidError; }
+  float gatherError() const { return m_gatherError; }
+
+private:
+  ForceLawMode m_mode;
+  vector<float> m_avoid;  // TABLE_CELLS + 1 values of avoid over [0, 1]
+  vector<float> m_gather; // TABLE_CELLS + 1 values of gather over [1, radius]
+  float m_gatherRadius;
+  float m_gatherScale;    // cells per unit of distance
+  float m_avoidError;     // largest difference to the pow version
+  float m_gatherError;
+};
+
+inline float ForceLaws::avoid(float r) const {
+  if (m_mode == POLYNOMIAL_LAWS) {
+    float rr = r * r;
+    return 1.f + rr * (-6.f + r * (8.f - 3.f * r));
+  }
+  float x = min(max(r, 0.f), 1.f) * TABLE_CELLS;
+  int k = min(int(x), TABLE_CELLS - 1);
+  return m_avoid[k] + (x - k) * (m_avoid[k + 1] - m_avoid[k]);
+}
+
+inline float ForceLaws::gather(float distance) const {
+  if (distance <= 1) {
+    return 1.f;
+  }
+  if (m_mode == POLYNOMIAL_LAWS || distance >= m_gatherRadius) {
+    return 1.f / (distance * distance);
+  }
+  float x = (distance - 1.f) * m_gatherScale;
+  int k = min(int(x), TABLE_CELLS - 1);
+  return m_gather[k] + (x - k) * (m_gather[k + 1] - m_gather[k]);
+}
+
+#endif // FORCE_LAWS_H
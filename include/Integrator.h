@@ -0,0 +1,53 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Velocity and position update at the end of a step, with the box bounce
+ */
+
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+using namespace std;
+
+// For every boid of a run (one tile, or the whole store without tiles):
+// the force is clamped to +-maxForce on every axis, v += force / mass * dt
+// is clamped to +-maxSpeed, p += v * dt (semi-implicit Euler), and on every
+// axis where the boid left the box it is put back at edge-1 and its
+// velocity on that axis is flipped.
+// integrateVector does 8 boids (AVX) or 4 (SSE) at a time without a branch,
+// with min, max and blends, and the last few with the scalar code.
+// integrateScalar is the reference: every lane goes through the same
+// operations in the same order, nothing is fused, and min and max pick the
+// same operand as the SSE instructions, so both give the same bits.
+
+struct StepRun {
+  float const *px; // state at the start of the step
+  float const *py;
+  float const *pz;
+  float const *vx;
+  float const *vy;
+  float const *vz;
+  float const *fx;
+  float const *fy;
+  float const *fz;
+  float const *mass;
+  float const *maxForce; // per boid (make PARAMS=1), or 0 to use fmax
+  float const *maxSpeed; // per boid, or 0 to use vmax
+  float *nextPx;         // state at the end of the step
+  float *nextPy;
+  float *nextPz;
+  float *nextVx;
+  float *nextVy;
+  float *nextVz;
+  int count;
+  float fmax;
+  float vmax;
+  float deltaT;
+  float edge; // half the side of the box
+};
+
+void integrateScalar(StepRun const &run);
+void integrateVector(StepRun const &run);
+
+#endif // INTEGRATOR_H
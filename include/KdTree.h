@@ -0,0 +1,68 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * k-d tree used to find the k nearest boids of every boid
+ */
+
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+#include "PageAllocator.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+// Implicit k-d tree: the boid indices are arranged so every range is split
+// at its middle element along its widest axis, no nodes are allocated. The
+// top levels of the build and the k nearest searches are spread over
+// several threads, those of a pool that is kept from one step to the next.
+//
+// For the force loop the k nearest of every boid are turned into pairs.
+// A pair is kept if either boid has the other among its k nearest, so each
+// boid handles about k pairs no matter how crowded it is.
+
+class KdTree {
+public:
+  enum { LEAF_SIZE = 8 };
+
+  KdTree();
+  void build(BoidStore const &boids, int numThreads);
+  void allNearest(int k, int numThreads, vector<int> &out);
+  void buildPairs(int k, int numThreads);
+  void neighbours(int i, vector<int> &out) const;
+
+private:
+  int splitRange(int lo, int hi);
+  void buildRange(int lo, int hi);
+  static void splitJob(void *tree, int part);
+  static void buildJob(void *tree, int part);
+  static void nearestJob(void *tree, int part);
+  void search(int lo, int hi, Vec3f const &pos, int self, int k, int *best,
+              float *bestDist, int &found) const;
+  void nearestRange(int first, int last, int k, int *out,
+                    float *bestDist) const;
+
+  vector<Vec3f> m_points; // positions in tree order
+  vector<int> m_index;    // boid at each tree position
+  vector<char> m_axis;    // split axis of the range whose middle is here
+  vector<int> m_nearest;  // k nearest of every boid
+  vector<int> m_start;    // offset of each boid's pairs in m_pairs (+1 end marker)
+  vector<int, PageAllocator<int> > m_pairs; // for every boid the boids j > i it is paired with
+  vector<int> m_next;     // where the next pair of each boid goes
+
+  // kept between steps so the threads and their work don't allocate
+  WorkerPool m_pool;
+  vector<pair<int, int> > m_ranges;     // subtrees handed to the threads
+  vector<pair<int, int> > m_nextRanges; // their halves, one level down
+  vector<int> m_splits;                 // middle of each range, -1 for a leaf
+  vector<float> m_bestDist;             // k distances for every part
+  int m_k;                              // of the search being run
+  int m_parts;
+  int *m_out;
+};
+
+#endif // KD_TREE_H
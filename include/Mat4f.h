@@ -14,7 +14,6 @@
 #define MAT4F_H
 
 #include <assert.h>
-#include <memory>
 #include <initializer_list>
 #include <array>
 #include <functional>
@@ -24,13 +23,15 @@
 
 // Stores a 4 by 4 Matrix in Row Major order.
 // When passing to glUniform4x4fv, turn on transpose.
+// The elements are stored inside the object, so copying a matrix is a plain
+// 64 byte copy and temporaries never touch the heap. Indices are only
+// checked when asserts are on (make DEBUG=1).
 
 class Mat4f {
 public:
   enum { DIM = 4, NUM_ELEM = 16 };
 
   typedef std::array<float, NUM_ELEM> ARRAY_16f;
-  typedef std::unique_ptr<ARRAY_16f> Mat4fHandle;
 
 public:
   explicit Mat4f();
@@ -39,10 +40,10 @@ public:
   // not explicit, so Mat4f m = {1,...,16};
   Mat4f(std::initializer_list<float> list);
   // Move constructor
-  Mat4f(Mat4f &&moved);
+  Mat4f(Mat4f &&moved) = default;
   // Copy Constructor
-  Mat4f(const Mat4f &copied);
-  ~Mat4f();
+  Mat4f(const Mat4f &copied) = default;
+  ~Mat4f() = default;
 
   float &operator()(int row, int column);
   float &operator[](int element);
@@ -55,8 +56,8 @@ public:
   Mat4f operator*(const Mat4f &other) const;
   Mat4f operator*(float scalar) const;
 
-  Mat4f &operator=(const Mat4f &copied);
-  Mat4f &operator=(Mat4f &&moved);
+  Mat4f &operator=(const Mat4f &copied) = default;
+  Mat4f &operator=(Mat4f &&moved) = default;
 
   bool isValidDimIndex(int idx) const;
   bool isValidElementIndex(int idx) const;
@@ -71,9 +72,51 @@ public:
   float const *data() const;
 
 private:
-  Mat4fHandle m_ptr;
+  alignas(16) ARRAY_16f m_data;
 };
 
 std::ostream &operator<<(std::ostream &, const Mat4f &mat);
 
+inline float &Mat4f::operator()(int row, int column) {
+  assert(isValidDimIndex(row) && isValidDimIndex(column));
+  return m_data[row * DIM + column];
+}
+
+inline float Mat4f::operator()(int row, int column) const {
+  assert(isValidDimIndex(row) && isValidDimIndex(column));
+  return m_data[row * DIM + column];
+}
+
+inline float &Mat4f::operator[](int element) {
+  assert(isValidElementIndex(element));
+  return m_data[element];
+}
+
+inline float Mat4f::operator[](int element) const {
+  assert(isValidElementIndex(element));
+  return m_data[element];
+}
+
+inline float const *Mat4f::data() const { return m_data.data(); }
+
+inline Mat4f::ARRAY_16f::iterator Mat4f::begin() { return m_data.begin(); }
+
+inline Mat4f::ARRAY_16f::iterator Mat4f::end() { return m_data.end(); }
+
+inline Mat4f::ARRAY_16f::const_iterator Mat4f::begin() const {
+  return m_data.begin();
+}
+
+inline Mat4f::ARRAY_16f::const_iterator Mat4f::end() const {
+  return m_data.end();
+}
+
+inline bool Mat4f::isValidDimIndex(int idx) const {
+  return idx >= 0 && idx < DIM;
+}
+
+inline bool Mat4f::isValidElementIndex(int idx) const {
+  return idx >= 0 && idx < NUM_ELEM;
+}
+
 #endif // MAT4F_H
@@ -0,0 +1,29 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Z-curve ordering used to keep nearby boids next to each other in memory
+ */
+
+#ifndef MORTON_ORDER_H
+#define MORTON_ORDER_H
+
+#include <vector>
+#include <stdint.h>
+#include <utility>
+#include "Vec3f.h"
+#include "BoidStore.h"
+
+using namespace std;
+
+// Interleaves the bits of three 10 bit cell coordinates, cells that are
+// close in space get codes that are close together.
+uint32_t mortonCode(uint32_t x, uint32_t y, uint32_t z);
+
+// Fills order with the indices of the live boids sorted by the Morton code
+// of the grid cell (of size cellSize, from -edge) each boid is in. keys is
+// where they are sorted, keep it between calls so sorting doesn't allocate.
+void mortonOrder(BoidStore const &boids, float cellSize, float edge,
+                 vector<int> &order, vector<pair<uint32_t, int> > &keys);
+
+#endif // MORTON_ORDER_H
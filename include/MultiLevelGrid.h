@@ -0,0 +1,38 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Two uniform grids of different cell sizes over the same boids
+ */
+
+#ifndef MULTI_LEVEL_GRID_H
+#define MULTI_LEVEL_GRID_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+#include "UniformGrid.h"
+
+using namespace std;
+
+// Avoidance only reaches rA, which is much smaller than the cohesion and
+// gathering radii. The fine level has cells the size of rA so the avoidance
+// pass only looks at boids that are really close, the coarse level has
+// cells the size of the largest radius for the rest. The levels are built
+// separately so the coarse one can be kept for several steps.
+
+class MultiLevelGrid {
+public:
+  MultiLevelGrid();
+  void buildFine(BoidStore const &boids, float cellSize, float edge);
+  void buildCoarse(BoidStore const &boids, float cellSize,
+                   float edge);
+  void fineHalfShell(int i, vector<int> &out) const;
+  void coarseHalfShell(int i, vector<int> &out) const;
+
+private:
+  UniformGrid m_fine;
+  UniformGrid m_coarse;
+};
+
+#endif // MULTI_LEVEL_GRID_H
@@ -0,0 +1,69 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Octree over the bounding box that is kept up to date as boids move
+ */
+
+#ifndef OCTREE_H
+#define OCTREE_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+
+using namespace std;
+
+// Leaves split into eight when they hold more than SPLIT boids and a branch
+// folds back into one leaf when it drops to MERGE boids, so dense clusters
+// get small cells and empty space stays coarse. Each leaf keeps its boids in
+// a linked list through m_next/m_prev, so moving a boid from one leaf to
+// another is O(depth) and the tree never has to be rebuilt while the boids
+// stay inside the root cube.
+
+class Octree {
+public:
+  enum { SPLIT = 32, MERGE = 16, MAX_DEPTH = 12 };
+
+  Octree();
+  void build(BoidStore const &boids, float edge);
+  bool isValid(int numBoids) const;
+  void clear();
+  void update(int i, Vec3f const &pos);
+  void erase(int i);
+  void query(Vec3f const &pos, float radius, vector<int> &out) const;
+  void neighbours(int i, float radius, vector<int> &out) const;
+  int leafCount() const;
+
+private:
+  struct Node {
+    Vec3f centre;
+    float half;     // half the side length of the cube
+    int parent;
+    int firstChild; // the eight children are stored together, -1 for a leaf
+    int count;      // boids anywhere under this node
+    int head;       // first boid in a leaf's list, -1 if empty
+    int depth;
+  };
+
+  int childFor(Node const &node, Vec3f const &pos) const;
+  bool contains(Node const &node, Vec3f const &pos) const;
+  void insert(int i);
+  void remove(int i);
+  void foldAbove(int leaf);
+  void link(int node, int i);
+  void split(int node);
+  void collapse(int node);
+  int allocChildren();
+
+  bool m_valid;
+  vector<Node> m_nodes;
+  vector<int> m_freeChildren; // first node of each unused block of eight
+  vector<Vec3f> m_pos;        // position each boid was filed under
+  vector<int> m_leaf;         // leaf holding each boid, -1 if not filed
+  vector<int> m_next;         // next boid in the same leaf, -1 at the end
+  vector<int> m_prev;         // previous boid in the same leaf, -1 at the start
+  mutable vector<int> m_stack;
+};
+
+#endif // OCTREE_H
@@ -0,0 +1,69 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Memory for the big arrays of the simulation, on huge pages when possible
+ */
+
+#ifndef PAGE_ALLOCATOR_H
+#define PAGE_ALLOCATOR_H
+
+#include <cstddef>
+
+using namespace std;
+
+// With a million boids the boid arrays and the neighbour index take hundreds
+// of MB, and on 4KB pages the pair loop keeps missing the TLB. Anything of
+// at least LARGE_SIZE bytes is mapped on its own, rounded up to whole huge
+// pages, and asked to be backed by huge pages as set with setPageMode:
+//   NORMAL_PAGES            plain mapping
+//   TRANSPARENT_HUGE_PAGES  mapping on a 2MB boundary marked with madvise
+//   HUGETLB_PAGES           mapping from the hugetlbfs pool (needs pages
+//                           set aside in /proc/sys/vm/nr_hugepages)
+// A request that fails falls back to the next mode down, so at worst the
+// memory is on normal pages. Smaller pieces use posix_memalign as before.
+// Nothing is touched here: on NUMA machines a page goes on the node of the
+// thread that first writes it, and every array is first filled by the
+// thread that goes on to use it (the main thread for the boid arrays, the
+// grids and the pair lists).
+// Off Linux everything uses posix_memalign.
+
+enum PageMode { NORMAL_PAGES = 0, TRANSPARENT_HUGE_PAGES = 1, HUGETLB_PAGES = 2 };
+
+enum { HUGE_PAGE_SIZE = 2 * 1024 * 1024, LARGE_SIZE = HUGE_PAGE_SIZE };
+
+void setPageMode(PageMode mode);
+PageMode pageMode();
+size_t pageFallbacks(); // large mappings that got a lower mode than asked for
+size_t pageRound(size_t bytes);
+void *allocatePages(size_t bytes, size_t alignment);
+void freePages(void *data, size_t bytes);
+
+// Standard allocator over allocatePages, for vectors holding one entry (or a
+// few) per boid
+template <typename T>
+class PageAllocator {
+public:
+  typedef T value_type;
+
+  PageAllocator() {}
+  template <typename U>
+  PageAllocator(PageAllocator<U> const &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(allocatePages(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *data, size_t n) { freePages(data, n * sizeof(T)); }
+};
+
+template <typename T, typename U>
+inline bool operator==(PageAllocator<T> const &, PageAllocator<U> const &) {
+  return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(PageAllocator<T> const &, PageAllocator<U> const &) {
+  return false;
+}
+
+#endif // PAGE_ALLOCATOR_H
@@ -0,0 +1,58 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Pair loop that works on 8 or 16 partners of a boid at once
+ */
+
+#ifndef PAIR_KERNEL_H
+#define PAIR_KERNEL_H
+
+#include "BoidStore.h"
+
+using namespace std;
+
+// The same pair loop as interactPairsFrom in main.cpp, for the boids in the
+// store with the scenario's parameters: the distances, the bands and the
+// avoidance and gathering strengths of 8 (AVX2) or 16 (AVX-512) partners
+// are worked out together, then the forces on the partners and the
+// cohesion sums are written one partner at a time. The force on boid i is
+// summed across the lanes and added once at the end.
+// The strengths are worked out in float with the same laws as favoid and
+// fgather, (1-r)^3 (3r+1) and 1/d^2, which is W 0 and W 2 up to rounding,
+// so the forces can differ from interactPairsFrom in the last bits. main.cpp
+// uses interactPairsFrom for the tables of W 1.
+// Which kernel runs is picked from what the CPU says it has (cpuid). On
+// every other CPU and compiler SCALAR_PAIRS goes one partner at a time with
+// the same laws.
+
+enum PairKernel { SCALAR_PAIRS = 0, AVX2_PAIRS = 1, AVX512_PAIRS = 2 };
+
+// Everything the kernels read and write for the pairs of one boid
+struct PairJob {
+  float const *px; // columns of the store, read at BoidStore::slot
+  float const *py;
+  float const *pz;
+  float const *vx;
+  float const *vy;
+  float const *vz;
+  unsigned char const *alive;
+  float *fx; // force columns the pairs add to
+  float *fy;
+  float *fz;
+  float *neighbourVel; // summed velocity of the cohesion neighbours, x y z per boid
+  float *cohesionSum;
+  int *neighbourCount;
+  float rA, rC;
+  float wA, wC, wG;
+  float nearest; // only pairs at least nearest and less than furthest apart
+  float furthest;
+};
+
+PairKernel bestPairKernel();
+char const *pairKernelName(PairKernel kernel);
+// Boid i with partners[0..count), which must not repeat
+void interactPairsBatch(PairKernel kernel, PairJob const &job, int i,
+                        int const *partners, int count);
+
+#endif // PAIR_KERNEL_H
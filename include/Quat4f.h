@@ -4,6 +4,7 @@
 #include <ostream>
 #include <cmath>
 #include "Vec3f.h"
+#include "Vec3fA.h"
 #include "Mat4f.h"
 
 class Quat4f {
@@ -32,6 +33,7 @@ public:
 
   Quat4f operator*(Quat4f const &q) const;
   Vec3f operator*(Vec3f const &v) const;
+  Vec3fA operator*(Vec3fA const &v) const;
   void operator*=(Quat4f const &q);
   Quat4f operator~() const;
   Quat4f inv() const;
@@ -62,6 +64,7 @@ std::ostream &operator<<(std::ostream &out, Quat4f const &q);
 Quat4f slerp(Quat4f const &q0, Quat4f const &q1, float t);
 Vec3f rotateAround(Vec3f const &vec, Vec3f const &axis, float radians);
 void rotateAround(Vec3f &vec, Vec3f const &axis, float radians);
+void rotateAround(Vec3fA &vec, Vec3fA const &axis, float radians);
 
 inline Quat4f::Quat4f(float re, float iV, float jV, float kV)
     : m_re(re), m_im(iV, jV, kV) {}
@@ -148,12 +151,16 @@ inline Quat4f Quat4f::operator*(Quat4f const &q) const {
 }
 
 inline Vec3f Quat4f::operator*(Vec3f const &v) const {
-  Quat4f qV(v);
+  return (*this * Vec3fA(v)).toVec3f();
+}
 
-  Quat4f result = qV * ~(*this);
-  result = (*this) * result;
+// q v ~q without building the two quaternion products, for any q (a unit
+// one rotates v, others scale it by normSquared() as well)
+inline Vec3fA Quat4f::operator*(Vec3fA const &v) const {
+  Vec3fA u(m_im);
+  float w = m_re;
 
-  return result.im();
+  return v * (w * w - u * u) + u * (2.f * (u * v)) + (u ^ v) * (2.f * w);
 }
 
 inline Mat4f Quat4f::matrix4f() const {
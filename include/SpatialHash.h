@@ -0,0 +1,53 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Hashed grid used to find the boids that are close enough to interact
+ */
+
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+#include "PageAllocator.h"
+
+using namespace std;
+
+// Same cells as UniformGrid, but only the cells that hold a boid are stored.
+// Cell coordinates are hashed into an open addressing table with about two
+// slots per boid, so memory follows the number of boids instead of the size
+// of the bounding box, and boids are never clamped to the box. halfShell
+// works the same way as in UniformGrid.
+
+class SpatialHash {
+public:
+  SpatialHash();
+  void build(BoidStore const &boids, float cellSize);
+  void neighbours(int i, vector<int> &out) const;
+  void halfShell(int i, vector<int> &out) const;
+  int cellCount() const;
+
+private:
+  struct Slot {
+    int x, y, z; // cell coordinates
+    int cell;    // compact cell number, -1 if the slot is empty
+  };
+
+  int findSlot(int x, int y, int z) const;
+  int cellCoord(float value) const;
+  void appendCell(int x, int y, int z, vector<int> &out) const;
+
+  float m_cellSize;
+  unsigned int m_mask;     // table size - 1, the size is a power of two
+  vector<Slot> m_table;
+  vector<int> m_cellSlot;  // table slot of each occupied cell
+  vector<int> m_cellStart; // offset of each cell in m_sorted (+1 end marker)
+  vector<int, PageAllocator<int> > m_sorted; // boid indices grouped by cell
+  vector<int, PageAllocator<int> > m_boidCell; // cell each boid was put into
+  vector<int, PageAllocator<int> > m_boidSlot; // where each boid ended up in m_sorted
+  vector<int> m_next;      // next free place in each cell while scattering
+};
+
+#endif // SPATIAL_HASH_H
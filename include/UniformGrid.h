@@ -0,0 +1,55 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Uniform grid used to find the boids that are close enough to interact
+ */
+
+#ifndef UNIFORM_GRID_H
+#define UNIFORM_GRID_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+#include "PageAllocator.h"
+
+using namespace std;
+
+// Splits the bounding box into cubes the size of the largest interaction
+// radius, so any boid within that radius of another is in one of the 27
+// cells around it. Boids are bucketed with a counting sort, so rebuilding
+// every step is linear in the number of boids.
+//
+// halfShell only looks forward: the boids after i in its own cell and the
+// 13 neighbouring cells that come after it (in z, then y, then x order).
+// Over all boids that gives every pair exactly once, so the force on both
+// boids can be applied with no j > i check.
+//
+// There are at most MAX_DIM cells along each axis (8MB of cell offsets),
+// past that the cells are made larger than the radius.
+
+class UniformGrid {
+public:
+  enum { MAX_DIM = 128 };
+
+  UniformGrid();
+  void build(BoidStore const &boids, float cellSize, float edge);
+  void neighbours(int i, vector<int> &out) const;
+  void halfShell(int i, vector<int> &out) const;
+  int cellCount() const;
+
+private:
+  int cellCoord(float value) const;
+  void appendRun(int z, int y, int xFirst, int xLast, vector<int> &out) const;
+
+  float m_cellSize;
+  float m_min;             // lowest corner of the box on every axis
+  int m_dim;               // cells along each axis
+  vector<int> m_cellStart; // offset of each cell in m_sorted (+1 end marker)
+  vector<int, PageAllocator<int> > m_sorted; // boid indices grouped by cell
+  vector<int, PageAllocator<int> > m_boidCell; // cell each boid was put into
+  vector<int, PageAllocator<int> > m_boidSlot; // where each boid ended up in m_sorted
+  vector<int> m_next;      // next free place in each cell while scattering
+};
+
+#endif // UNIFORM_GRID_H
@@ -66,7 +66,7 @@ public:
   Vec3f operator/(float factor) const;
   Vec3f operator+(const Vec3f &other) const;
   Vec3f operator-(const Vec3f &other) const;
-  Vec3f &operator=(Vec3f other); // assignment operator
+  Vec3f &operator=(Vec3f const &other) = default; // assignment operator
   void operator+=(const Vec3f &other);
   void operator-=(const Vec3f &other);
   void operator*=(float factor);
@@ -172,11 +172,6 @@ inline Vec3f Vec3f::operator^(Vec3f const &other) const {
   return crossProduct(other);
 }
 
-inline Vec3f &Vec3f::operator=(Vec3f other) {
-  swap(other, *this);
-  return *this;
-}
-
 inline Vec3f Vec3f::operator-() const {
   Vec3f v(*this);
   v *= -1.f;
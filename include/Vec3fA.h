@@ -0,0 +1,204 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Vec3f padded to 16 bytes so it fits in one SSE register
+ */
+
+#ifndef VEC3FA_H
+#define VEC3FA_H
+
+#include <iostream>
+#include <cmath>
+#include "Vec3f.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#define VEC3FA_SSE 1
+#include <xmmintrin.h>
+#else
+#define VEC3FA_SSE 0
+#endif
+
+// x, y and z plus a w that is always 0, 16 byte aligned, so every operator
+// is one or a few SSE instructions instead of three scalar ones. Anything
+// done lane by lane (+, -, scaling, clamp) gives exactly what Vec3f gives;
+// the dot product and what is built on it add the lanes in a different
+// order and can differ in the last bit. Converts to and from Vec3f, which
+// stays the type that is stored in arrays and sent to OpenGL.
+// Without SSE the same operators work on four floats.
+
+class Vec3fA {
+public:
+  explicit Vec3fA(float x = 0.f, float y = 0.f, float z = 0.f);
+  explicit Vec3fA(Vec3f const &v);
+  Vec3f toVec3f() const;
+
+  float x() const;
+  float y() const;
+  float z() const;
+
+  Vec3fA operator+(Vec3fA const &other) const;
+  Vec3fA operator-(Vec3fA const &other) const;
+  Vec3fA operator-() const;
+  Vec3fA operator*(float factor) const;
+  Vec3fA operator/(float factor) const;
+  void operator+=(Vec3fA const &other);
+  void operator-=(Vec3fA const &other);
+  void operator*=(float factor);
+
+  float operator*(Vec3fA const &other) const;  // dot product
+  Vec3fA operator^(Vec3fA const &other) const; // cross product
+
+  float lengthSquared() const;
+  float length() const;
+  float distance(Vec3fA const &other) const;
+  Vec3fA normalized() const;
+  void normalize();
+  Vec3fA clamped(float limit) const; // every component within +-limit
+
+private:
+#if VEC3FA_SSE
+  explicit Vec3fA(__m128 v) : m_v(v) {}
+  __m128 m_v;
+#else
+  alignas(16) float m_v[4];
+#endif
+};
+
+std::ostream &operator<<(std::ostream &out, Vec3fA const &vec);
+
+#if VEC3FA_SSE
+inline Vec3fA::Vec3fA(float x, float y, float z)
+    : m_v(_mm_set_ps(0.f, z, y, x)) {}
+
+inline float Vec3fA::x() const { return _mm_cvtss_f32(m_v); }
+
+inline float Vec3fA::y() const {
+  return _mm_cvtss_f32(_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+inline float Vec3fA::z() const {
+  return _mm_cvtss_f32(_mm_movehl_ps(m_v, m_v));
+}
+
+inline Vec3fA Vec3fA::operator+(Vec3fA const &other) const {
+  return Vec3fA(_mm_add_ps(m_v, other.m_v));
+}
+
+inline Vec3fA Vec3fA::operator-(Vec3fA const &other) const {
+  return Vec3fA(_mm_sub_ps(m_v, other.m_v));
+}
+
+inline Vec3fA Vec3fA::operator-() const {
+  return Vec3fA(_mm_sub_ps(_mm_setzero_ps(), m_v));
+}
+
+inline Vec3fA Vec3fA::operator*(float factor) const {
+  return Vec3fA(_mm_mul_ps(m_v, _mm_set1_ps(factor)));
+}
+
+// divides rather than multiplying by 1/factor, like Vec3f, so the results
+// match
+inline Vec3fA Vec3fA::operator/(float factor) const {
+  return Vec3fA(_mm_div_ps(m_v, _mm_set1_ps(factor)));
+}
+
+inline float Vec3fA::operator*(Vec3fA const &other) const {
+  __m128 m = _mm_mul_ps(m_v, other.m_v);          // x y z 0
+  __m128 s = _mm_add_ps(m, _mm_movehl_ps(m, m));  // x+z y+0
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(s);
+}
+
+inline Vec3fA Vec3fA::operator^(Vec3fA const &other) const {
+  // a * b.yzx - a.yzx * b gives the cross product in zxy order
+  __m128 a = _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 b = _mm_shuffle_ps(other.m_v, other.m_v, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 c = _mm_sub_ps(_mm_mul_ps(m_v, b), _mm_mul_ps(a, other.m_v));
+  return Vec3fA(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+inline Vec3fA Vec3fA::clamped(float limit) const {
+  __m128 high = _mm_set1_ps(limit);
+  __m128 low = _mm_set1_ps(-limit);
+  return Vec3fA(_mm_min_ps(_mm_max_ps(m_v, low), high));
+}
+#else
+inline Vec3fA::Vec3fA(float x, float y, float z) {
+  m_v[0] = x;
+  m_v[1] = y;
+  m_v[2] = z;
+  m_v[3] = 0.f;
+}
+
+inline float Vec3fA::x() const { return m_v[0]; }
+inline float Vec3fA::y() const { return m_v[1]; }
+inline float Vec3fA::z() const { return m_v[2]; }
+
+inline Vec3fA Vec3fA::operator+(Vec3fA const &other) const {
+  return Vec3fA(m_v[0] + other.m_v[0], m_v[1] + other.m_v[1],
+                m_v[2] + other.m_v[2]);
+}
+
+inline Vec3fA Vec3fA::operator-(Vec3fA const &other) const {
+  return Vec3fA(m_v[0] - other.m_v[0], m_v[1] - other.m_v[1],
+                m_v[2] - other.m_v[2]);
+}
+
+inline Vec3fA Vec3fA::operator-() const {
+  return Vec3fA(-m_v[0], -m_v[1], -m_v[2]);
+}
+
+inline Vec3fA Vec3fA::operator*(float factor) const {
+  return Vec3fA(m_v[0] * factor, m_v[1] * factor, m_v[2] * factor);
+}
+
+inline Vec3fA Vec3fA::operator/(float factor) const {
+  return Vec3fA(m_v[0] / factor, m_v[1] / factor, m_v[2] / factor);
+}
+
+inline float Vec3fA::operator*(Vec3fA const &other) const {
+  return (m_v[0] * other.m_v[0] + m_v[2] * other.m_v[2]) +
+         m_v[1] * other.m_v[1];
+}
+
+inline Vec3fA Vec3fA::operator^(Vec3fA const &other) const {
+  return Vec3fA(m_v[1] * other.m_v[2] - m_v[2] * other.m_v[1],
+                m_v[2] * other.m_v[0] - m_v[0] * other.m_v[2],
+                m_v[0] * other.m_v[1] - m_v[1] * other.m_v[0]);
+}
+
+inline Vec3fA Vec3fA::clamped(float limit) const {
+  Vec3fA out;
+  for (int k = 0; k < 3; k++) {
+    out.m_v[k] = std::min(std::max(m_v[k], -limit), limit);
+  }
+  return out;
+}
+#endif
+
+inline Vec3fA::Vec3fA(Vec3f const &v) { *this = Vec3fA(v.x(), v.y(), v.z()); }
+
+inline Vec3f Vec3fA::toVec3f() const { return Vec3f(x(), y(), z()); }
+
+inline void Vec3fA::operator+=(Vec3fA const &other) { *this = *this + other; }
+
+inline void Vec3fA::operator-=(Vec3fA const &other) { *this = *this - other; }
+
+inline void Vec3fA::operator*=(float factor) { *this = *this * factor; }
+
+inline float Vec3fA::lengthSquared() const { return *this * *this; }
+
+inline float Vec3fA::length() const { return std::sqrt(lengthSquared()); }
+
+inline float Vec3fA::distance(Vec3fA const &other) const {
+  return (*this - other).length();
+}
+
+inline Vec3fA Vec3fA::normalized() const { return *this / length(); }
+
+inline void Vec3fA::normalize() { *this = normalized(); }
+
+inline Vec3fA operator*(float scalar, Vec3fA const &vec) { return vec * scalar; }
+
+#endif // VEC3FA_H
@@ -0,0 +1,45 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Verlet neighbour lists that are kept for several steps
+ */
+
+#ifndef VERLET_LIST_H
+#define VERLET_LIST_H
+
+#include <vector>
+#include "Vec3f.h"
+#include "BoidStore.h"
+#include "SpatialHash.h"
+#include "PageAllocator.h"
+
+using namespace std;
+
+// Every pair within radius + skin is kept on the list of one of its boids. As
+// long as no boid has moved more than half the skin since the lists were
+// made, no pair can have come within radius without being on a list, so
+// the same lists can be used again for the next step.
+
+class VerletList {
+public:
+  VerletList();
+  bool needsRebuild(BoidStore const &boids) const;
+  void build(BoidStore const &boids, float radius, float skin);
+  void clear();
+  void neighbours(int i, vector<int> &out) const;
+  int stepsReused() const;
+  void markUsed();
+
+private:
+  float m_skin;
+  int m_stepsReused;        // steps the current lists have been used after the first
+  bool m_used;              // whether the current lists have been used yet
+  SpatialHash m_hash;       // finds the candidates when the lists are made
+  vector<Vec3f> m_buildPos; // positions when the lists were made
+  vector<int> m_start;      // offset of each boid's list in m_list (+1 end marker)
+  vector<int, PageAllocator<int> > m_list; // all lists packed one after another
+  vector<int> m_candidates;
+};
+
+#endif // VERLET_LIST_H
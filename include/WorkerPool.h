@@ -0,0 +1,54 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ *
+ * Threads that are started once and then reused for every step
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Starting a thread allocates, so the work of a step is handed to threads
+// that wait between steps instead. run(job, context, parts) calls
+// job(context, p) for every part p, spread over the calling thread and the
+// workers, and returns once all of them are done. Parts beyond the number
+// of threads are taken in turn, so any number of parts can be run.
+
+class WorkerPool {
+public:
+  typedef void (*Job)(void *context, int part);
+
+  WorkerPool();
+  ~WorkerPool();
+  void resize(int numThreads);
+  int size() const;
+  void run(Job job, void *context, int parts);
+
+private:
+  WorkerPool(WorkerPool const &);
+  WorkerPool &operator=(WorkerPool const &);
+
+  void stop();
+  void work(int worker, int seen);
+  void runParts(int first);
+
+  vector<thread> m_workers;
+  mutex m_mutex;
+  condition_variable m_wake; // a new job is there, or the pool stops
+  condition_variable m_done; // a worker finished its parts
+  Job m_job;
+  void *m_context;
+  int m_parts;
+  int m_generation; // counts the jobs, so a worker runs each only once
+  int m_busy;       // workers still on the current job
+  bool m_stopping;
+};
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,117 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "AllocationAudit.h"
+
+#include <stdlib.h>
+#include <cerrno>
+#include <atomic>
+#include <iostream>
+#include <new>
+
+#ifdef ALLOC_AUDIT
+// the k-d tree threads allocate too, so the counts are atomic
+static atomic<size_t> g_news(0);
+static atomic<size_t> g_mallocs(0);
+static atomic<size_t> g_pages(0);
+
+#ifdef __GLIBC__
+// glibc lets the program replace malloc, the real ones stay reachable here
+extern "C" void *__libc_malloc(size_t bytes);
+extern "C" void *__libc_calloc(size_t count, size_t bytes);
+extern "C" void *__libc_realloc(void *data, size_t bytes);
+extern "C" void *__libc_memalign(size_t alignment, size_t bytes);
+
+extern "C" void *malloc(size_t bytes) {
+  g_mallocs++;
+  return __libc_malloc(bytes);
+}
+
+extern "C" void *calloc(size_t count, size_t bytes) {
+  g_mallocs++;
+  return __libc_calloc(count, bytes);
+}
+
+extern "C" void *realloc(void *data, size_t bytes) {
+  g_mallocs++;
+  return __libc_realloc(data, bytes);
+}
+
+extern "C" int posix_memalign(void **data, size_t alignment, size_t bytes) {
+  g_mallocs++;
+  *data = __libc_memalign(alignment, bytes);
+  return *data ? 0 : ENOMEM;
+}
+
+// operator new goes straight to glibc so it isn't counted as a malloc too
+static void *rawAllocate(size_t bytes) {
+  return __libc_malloc(bytes ? bytes : 1);
+}
+#else
+static void *rawAllocate(size_t bytes) { return malloc(bytes ? bytes : 1); }
+#endif
+
+void *operator new(size_t bytes) {
+  g_news++;
+  void *data = rawAllocate(bytes);
+  if (data == NULL) {
+    throw std::bad_alloc();
+  }
+  return data;
+}
+
+void *operator new[](size_t bytes) { return operator new(bytes); }
+
+void operator delete(void *data) noexcept { free(data); }
+
+void operator delete[](void *data) noexcept { free(data); }
+#endif
+
+// ========================= OPERATORS ======================================//
+bool allocationAuditOn() {
+#ifdef ALLOC_AUDIT
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCount allocationCount() {
+  AllocationCount count;
+#ifdef ALLOC_AUDIT
+  count.news = g_news;
+  count.mallocs = g_mallocs;
+  count.pages = g_pages;
+#else
+  count.news = 0;
+  count.mallocs = 0;
+  count.pages = 0;
+#endif
+  return count;
+}
+
+void notePageAllocation() {
+#ifdef ALLOC_AUDIT
+  g_pages++;
+#endif
+}
+
+void expectNoAllocations(AllocationCount const &since, char const *what,
+                         int frame) {
+  AllocationCount now = allocationCount();
+  size_t news = now.news - since.news;
+  size_t mallocs = now.mallocs - since.mallocs;
+  size_t pages = now.pages - since.pages;
+
+  if (news + mallocs + pages == 0) {
+    return;
+  }
+  cerr << "ALLOCATION AUDIT FAILED: " << what << " of frame " << frame
+       << " made " << news << " new, " << mallocs << " malloc and " << pages
+       << " page allocations" << endl;
+  abort();
+}
+
+// ==========================================================================//
@@ -0,0 +1,194 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "BarnesHut.h"
+
+// Most cells a build can make for numBoids boids. A cell is only split
+// when it holds more than LEAF_SIZE boids and the cells at one depth don't
+// share any, so there are at most numBoids / (LEAF_SIZE + 1) split cells,
+// and 8^depth, at each depth. The leaves hold at least one boid each.
+static size_t maxCells(int numBoids) {
+  size_t split = 0;
+  size_t perDepth = 1;
+  size_t crowded = size_t(numBoids) / (BarnesHut::LEAF_SIZE + 1);
+  for (int depth = 0; depth < BarnesHut::MAX_DEPTH; depth++) {
+    split += min(perDepth, crowded);
+    perDepth = min(perDepth * 8, crowded + 1);
+  }
+  return split + min(size_t(numBoids), 1 + 7 * split);
+}
+
+// ======================== CONSTRUCTORS ============================//
+BarnesHut::BarnesHut() {}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void BarnesHut::build(BoidStore const &boids) {
+  int numBoids = boids.size();
+
+  m_points.resize(numBoids);
+  m_index.resize(numBoids);
+  m_scratch.resize(numBoids);
+  m_grouped.resize(numBoids);
+  m_cells.clear();
+  // only grows with the flock, so a step never has to
+  m_cells.reserve(maxCells(numBoids));
+  m_stack.reserve(7 * MAX_DEPTH + 8);
+  if (numBoids == 0) {
+    return;
+  }
+
+  // root cube around all the boids
+  Vec3f low = boids.position(0);
+  Vec3f high = low;
+  for (int i = 0; i < numBoids; i++) {
+    m_index[i] = i;
+    m_points[i] = boids.position(i);
+    for (int k = 0; k < 3; k++) {
+      low[k] = min(low[k], m_points[i][k]);
+      high[k] = max(high[k], m_points[i][k]);
+    }
+  }
+  Vec3f extent = high - low;
+  float half = 0.5f * max(extent.x(), max(extent.y(), extent.z())) + 0.001f;
+
+  buildCell(0, numBoids, (low + high) * 0.5f, half, 0);
+}
+
+// Total gathering pull on boid i from every other boid at least reach away,
+// the closer ones are left to the pair loop. law gives the strength for a
+// distance, like fgather.
+Vec3f BarnesHut::gather(int i, float theta, float reach,
+                        float (*law)(float)) const {
+  Vec3f force(0.f, 0.f, 0.f);
+  Vec3f const &pos = m_points[i];
+  float reach2 = reach * reach;
+
+  if (m_cells.empty()) {
+    return force;
+  }
+
+  m_stack.assign(1, 0);
+  while (!m_stack.empty()) {
+    Cell const &cell = m_cells[m_stack.back()];
+    m_stack.pop_back();
+
+    // squared distances from pos to the closest and furthest point of the
+    // cube
+    float closest = 0.f;
+    float furthest = 0.f;
+    for (int k = 0; k < 3; k++) {
+      float d = std::abs(pos[k] - cell.centre[k]);
+      float in = max(d - cell.half, 0.f);
+      furthest += (d + cell.half) * (d + cell.half);
+      closest += in * in;
+    }
+    if (furthest < reach2) {
+      continue; // every boid in it is in the pair loop's reach
+    }
+
+    if (cell.first >= 0) {
+      // leaf, every boid pulls on its own
+      for (int n = cell.first; n < cell.last; n++) {
+        int j = m_index[n];
+        Vec3f diff = m_points[j] - pos;
+        float dist = diff.length();
+        if (j != i && dist >= reach && dist > 0.f) {
+          force += (law(dist) / dist) * diff;
+        }
+      }
+      continue;
+    }
+
+    Vec3f diff = cell.massCentre - pos;
+    float dist = diff.length();
+    // far enough away (and not around i or any boid within reach of it) to
+    // count as one boid
+    if (closest >= reach2 && !inside(cell, pos) &&
+        2.f * cell.half < theta * dist) {
+      force += (cell.count * law(dist) / dist) * diff;
+      continue;
+    }
+    for (int c = 0; c < 8; c++) {
+      if (cell.child[c] >= 0) {
+        m_stack.push_back(cell.child[c]);
+      }
+    }
+  }
+  return force;
+}
+
+// Makes the cell for the boids in m_index[first, last), returns its number
+int BarnesHut::buildCell(int first, int last, Vec3f const &centre,
+                         float half, int depth) {
+  int number = int(m_cells.size());
+  Cell cell;
+  int n;
+
+  cell.centre = centre;
+  cell.half = half;
+  cell.count = last - first;
+  cell.first = -1;
+  cell.last = -1;
+  for (int c = 0; c < 8; c++) {
+    cell.child[c] = -1;
+  }
+  Vec3f sum(0.f, 0.f, 0.f);
+  for (n = first; n < last; n++) {
+    sum += m_points[m_index[n]];
+  }
+  cell.massCentre = sum / float(cell.count);
+  m_cells.push_back(cell);
+
+  if (cell.count <= LEAF_SIZE || depth >= MAX_DEPTH) {
+    m_cells[number].first = first;
+    m_cells[number].last = last;
+    return number;
+  }
+
+  // group the boids by octant with a counting sort
+  int start[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+  for (n = first; n < last; n++) {
+    Vec3f const &p = m_points[m_index[n]];
+    int octant = (p.x() >= centre.x() ? 1 : 0) |
+                 (p.y() >= centre.y() ? 2 : 0) |
+                 (p.z() >= centre.z() ? 4 : 0);
+    m_scratch[n] = octant;
+    start[octant + 1]++;
+  }
+  for (int c = 0; c < 8; c++) {
+    start[c + 1] += start[c];
+  }
+  int next[8];
+  for (int c = 0; c < 8; c++) {
+    next[c] = first + start[c];
+  }
+  for (n = first; n < last; n++) {
+    m_grouped[next[m_scratch[n]]++] = m_index[n];
+  }
+  copy(m_grouped.begin() + first, m_grouped.begin() + last,
+       m_index.begin() + first);
+
+  float quarter = half * 0.5f;
+  for (int c = 0; c < 8; c++) {
+    if (start[c + 1] > start[c]) {
+      Vec3f childCentre = centre + Vec3f((c & 1) ? quarter : -quarter,
+                                         (c & 2) ? quarter : -quarter,
+                                         (c & 4) ? quarter : -quarter);
+      int child = buildCell(first + start[c], first + start[c + 1],
+                            childCentre, quarter, depth + 1);
+      m_cells[number].child[c] = child;
+    }
+  }
+  return number;
+}
+
+bool BarnesHut::inside(Cell const &cell, Vec3f const &pos) const {
+  return std::abs(pos.x() - cell.centre.x()) <= cell.half &&
+         std::abs(pos.y() - cell.centre.y()) <= cell.half &&
+         std::abs(pos.z() - cell.centre.z()) <= cell.half;
+}
+
+// ==========================================================================//
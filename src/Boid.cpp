@@ -6,58 +6,51 @@
 #include "Boid.h"
 
 // ======================== CONSTRUCTORS ============================//
-Boid::Boid(Vec3f pos) {
-  position = pos;
-  mass = 1.f;
-  velocity = Vec3f(0.f,0.f,0.f);
-  force = Vec3f(0.f,0.f,0.f);
-  orientation = IdentityMatrix();
+Boid::Boid(BoidStore &store, int index) {
+  m_store = &store;
+  m_index = index;
 }
 // ==========================================================================//
 
 // ========================= OPERATORS ======================================//
-Vec3f Boid::getPos() {
-  return position;
+Vec3f Boid::getPos() const {
+  return m_store->position(m_index);
 }
 
 void Boid::setPos(Vec3f newPos) {
-  position = newPos;
+  m_store->setPosition(m_index, newPos);
 }
 
-Vec3f Boid::getForce() {
-  return force;
+Vec3f Boid::getForce() const {
+  return m_store->force(m_index);
 }
 
 void Boid::setForce(Vec3f newForce) {
-  force = newForce;
+  m_store->setForce(m_index, newForce);
 }
 
-float Boid::getMass() {
-  return mass;
+float Boid::getMass() const {
+  return m_store->mass(m_index);
 }
 
 void Boid::setMass(float newMass) {
-  mass = newMass;
+  m_store->setMass(m_index, newMass);
 }
 
-Vec3f Boid::getVelocity() {
-  return velocity;
+Vec3f Boid::getVelocity() const {
+  return m_store->velocity(m_index);
 }
 
 void Boid::setVelocity(Vec3f newVel) {
-  velocity = newVel;
+  m_store->setVelocity(m_index, newVel);
 }
 
 void Boid::resetForce() {
-  force = Vec3f(0.f,0.f,0.f);
+  m_store->setForce(m_index, Vec3f(0.f,0.f,0.f));
 }
 
-Mat4f Boid::getOrientation() {
-  return orientation;
-}
-
-void Boid::setOrientation(Mat4f newOrien) {
-  orientation = newOrien;
+int Boid::index() const {
+  return m_index;
 }
 
 // ==========================================================================//
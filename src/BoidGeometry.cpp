@@ -0,0 +1,199 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "BoidGeometry.h"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BOID_GEOMETRY_SSE 1
+#include <emmintrin.h>
+#else
+#define BOID_GEOMETRY_SSE 0
+#endif
+
+// ========================= OPERATORS ======================================//
+#if BOID_GEOMETRY_SSE
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Column c of the boids in slots s, in one load when they are next to each
+// other
+static inline __m128 load4(float const *c, int const *s) {
+  if (s[1] == s[0] + 1 && s[2] == s[0] + 2 && s[3] == s[0] + 3) {
+    return _mm_loadu_ps(c + s[0]);
+  }
+  return _mm_setr_ps(c[s[0]], c[s[1]], c[s[2]], c[s[3]]);
+}
+
+// The triangles of the boids in the four slots s, 9 floats per boid to
+// block. col holds the position and velocity columns.
+static void trianglesOf4(float const *const *col, int const *s, bool oriented,
+                         float *block) {
+  __m128 px = load4(col[0], s);
+  __m128 py = load4(col[1], s);
+  __m128 pz = load4(col[2], s);
+  __m128 zero = _mm_setzero_ps();
+  __m128 half = _mm_set1_ps(0.5f);
+  __m128 one = _mm_set1_ps(1.f);
+  __m128 vert[9]; // x y z of the nose, the upper and the lower tail
+
+  if (!oriented) {
+    vert[0] = _mm_sub_ps(px, half);
+    vert[1] = py;
+    vert[2] = pz;
+    vert[3] = _mm_add_ps(px, one);
+    vert[4] = _mm_add_ps(py, half);
+    vert[5] = pz;
+    vert[6] = vert[3];
+    vert[7] = _mm_sub_ps(py, half);
+    vert[8] = pz;
+  } else {
+    __m128 vx = load4(col[3], s);
+    __m128 vy = load4(col[4], s);
+    __m128 vz = load4(col[5], s);
+    // f, where the nose points: along the velocity, or to the left
+    __m128 speed2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)),
+                               _mm_mul_ps(vz, vz));
+    __m128 moving = _mm_cmpgt_ps(speed2, zero);
+    __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(speed2));
+    __m128 fx = select4(moving, _mm_mul_ps(vx, inv), _mm_sub_ps(zero, one));
+    __m128 fy = select4(moving, _mm_mul_ps(vy, inv), zero);
+    __m128 fz = select4(moving, _mm_mul_ps(vz, inv), zero);
+    // u, across the boid: f x (0, 0, 1), or up when f is along z
+    __m128 side2 = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy));
+    __m128 flat = _mm_cmpgt_ps(side2, _mm_set1_ps(1e-12f));
+    __m128 sideInv = _mm_div_ps(one, _mm_sqrt_ps(side2));
+    __m128 ux = select4(flat, _mm_mul_ps(fy, sideInv), zero);
+    __m128 uy = select4(flat, _mm_mul_ps(_mm_sub_ps(zero, fx), sideInv), one);
+    // nose at p + f/2, tail at p - f +- u/2
+    __m128 tx = _mm_sub_ps(px, fx);
+    __m128 ty = _mm_sub_ps(py, fy);
+    __m128 tz = _mm_sub_ps(pz, fz);
+    vert[0] = _mm_add_ps(px, _mm_mul_ps(fx, half));
+    vert[1] = _mm_add_ps(py, _mm_mul_ps(fy, half));
+    vert[2] = _mm_add_ps(pz, _mm_mul_ps(fz, half));
+    vert[3] = _mm_add_ps(tx, _mm_mul_ps(ux, half));
+    vert[4] = _mm_add_ps(ty, _mm_mul_ps(uy, half));
+    vert[5] = tz;
+    vert[6] = _mm_sub_ps(tx, _mm_mul_ps(ux, half));
+    vert[7] = _mm_sub_ps(ty, _mm_mul_ps(uy, half));
+    vert[8] = tz;
+  }
+
+  // from 9 floats by boid to boid by boid: the first 8 as two 4x4 blocks
+  _MM_TRANSPOSE4_PS(vert[0], vert[1], vert[2], vert[3]);
+  _MM_TRANSPOSE4_PS(vert[4], vert[5], vert[6], vert[7]);
+  alignas(16) float last[4];
+  _mm_store_ps(last, vert[8]);
+  for (int b = 0; b < 4; b++) {
+    _mm_storeu_ps(block + 9 * b, vert[b]);
+    _mm_storeu_ps(block + 9 * b + 4, vert[4 + b]);
+    block[9 * b + 8] = last[b];
+  }
+}
+
+// 4 boids are 144 bytes, so an aligned out stays aligned
+static inline void writeBlock(float const *block, float *out, bool aligned) {
+  for (int k = 0; k < 9; k++) {
+    __m128 v = _mm_load_ps(block + 4 * k);
+    if (aligned) {
+      _mm_stream_ps(out + 4 * k, v);
+    } else {
+      _mm_storeu_ps(out + 4 * k, v);
+    }
+  }
+}
+#else
+// One boid at a time, to block
+static void trianglesOf4(float const *const *col, int const *s, bool oriented,
+                         float *block) {
+  for (int b = 0; b < 4; b++, block += 9) {
+    float px = col[0][s[b]];
+    float py = col[1][s[b]];
+    float pz = col[2][s[b]];
+    float fx = -1.f, fy = 0.f, fz = 0.f; // where the nose points
+    float ux = 0.f, uy = 1.f;            // across the boid
+    if (oriented) {
+      float speed = std::sqrt(col[3][s[b]] * col[3][s[b]] +
+                              col[4][s[b]] * col[4][s[b]] +
+                              col[5][s[b]] * col[5][s[b]]);
+      if (speed > 0.f) {
+        fx = col[3][s[b]] / speed;
+        fy = col[4][s[b]] / speed;
+        fz = col[5][s[b]] / speed;
+      }
+      float side = std::sqrt(fx * fx + fy * fy);
+      if (side * side > 1e-12f) {
+        ux = fy / side;
+        uy = -fx / side;
+      }
+    }
+    block[0] = px + fx * 0.5f;
+    block[1] = py + fy * 0.5f;
+    block[2] = pz + fz * 0.5f;
+    block[3] = px - fx + ux * 0.5f;
+    block[4] = py - fy + uy * 0.5f;
+    block[5] = pz - fz;
+    block[6] = px - fx - ux * 0.5f;
+    block[7] = py - fy - uy * 0.5f;
+    block[8] = pz - fz;
+  }
+}
+
+static inline void writeBlock(float const *block, float *out, bool) {
+  for (int k = 0; k < 36; k++) {
+    out[k] = block[k];
+  }
+}
+#endif
+
+int boidTriangles(BoidStore &boids, float *out, bool oriented) {
+  float const *col[6] = {
+      boids.column(BoidStore::PX), boids.column(BoidStore::PY),
+      boids.column(BoidStore::PZ), boids.column(BoidStore::VX),
+      boids.column(BoidStore::VY), boids.column(BoidStore::VZ)};
+  bool aligned = (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+  alignas(16) float block[36];
+  int slots[4]; // of the live boids not written yet
+  int pending = 0;
+  int written = 0;
+
+  for (int k = 0; k < boids.tileCount(); k++) {
+    BoidStore::Tile t = boids.tile(k);
+    for (int lane = 0; lane < t.count(); lane++) {
+      if (!t.alive()[lane]) {
+        continue;
+      }
+      slots[pending++] = BoidStore::slot(t.first() + lane);
+      if (pending == 4) {
+        trianglesOf4(col, slots, oriented, block);
+        writeBlock(block, out + 9 * written, aligned);
+        written += 4;
+        pending = 0;
+      }
+    }
+  }
+  if (pending > 0) {
+    // the last boid fills in for the missing ones, only the real ones are
+    // written
+    for (int b = pending; b < 4; b++) {
+      slots[b] = slots[pending - 1];
+    }
+    trianglesOf4(col, slots, oriented, block);
+    for (int n = 0; n < 9 * pending; n++) {
+      out[9 * written + n] = block[n];
+    }
+    written += pending;
+  }
+#if BOID_GEOMETRY_SSE
+  _mm_sfence(); // the streamed vertices are out before the buffer is unmapped
+#endif
+  return written;
+}
+
+// ==========================================================================//
@@ -0,0 +1,213 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "BoidStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// ======================== CONSTRUCTORS ============================//
+template <int TILE>
+BasicBoidStore<TILE>::BasicBoidStore() {
+  m_size = 0;
+  m_capacity = 0;
+  m_freeCount = 0;
+  m_block = NULL;
+  m_alive = NULL;
+  m_free = NULL;
+  for (int c = 0; c < NUM_COLUMNS; c++) {
+    m_col[c] = NULL;
+  }
+}
+
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+// Grows the arrays to hold at least capacity boids, keeping the boids.
+// The old arrays stay in the arena until it is rewound, so reserving the
+// final size up front wastes nothing.
+template <int TILE>
+void BasicBoidStore<TILE>::reserve(int capacity) {
+  int perLine = ALIGNMENT / sizeof(float);
+  int round = max(perLine, TILE);
+
+  if (capacity <= m_capacity) {
+    return;
+  }
+  // round up so every column (or tile) starts on a new line
+  capacity = (capacity + round - 1) / round * round;
+  float *newBlock = static_cast<float *>(
+      m_arena.allocate(sizeof(float) * NUM_COLUMNS * capacity));
+
+  unsigned char *newAlive =
+      static_cast<unsigned char *>(m_arena.allocate(capacity));
+  int *newFree = static_cast<int *>(m_arena.allocate(sizeof(int) * capacity));
+
+  if (TILE == 0) {
+    for (int c = 0; c < NUM_COLUMNS; c++) {
+      if (m_size > 0) {
+        memcpy(newBlock + c * capacity, m_col[c], sizeof(float) * m_size);
+      }
+      m_col[c] = newBlock + c * capacity;
+    }
+  } else {
+    // the tiles don't depend on the capacity, so they move as they are
+    int used = (m_size + TILE - 1) / TILE * TILE * NUM_COLUMNS;
+    if (m_size > 0) {
+      memcpy(newBlock, m_block, sizeof(float) * used);
+    }
+    for (int c = 0; c < NUM_COLUMNS; c++) {
+      m_col[c] = m_block ? newBlock + (m_col[c] - m_block) : newBlock + c * TILE;
+    }
+  }
+  if (m_size > 0) {
+    memcpy(newAlive, m_alive, m_size);
+  }
+  if (m_freeCount > 0) {
+    memcpy(newFree, m_free, sizeof(int) * m_freeCount);
+  }
+  m_block = newBlock;
+  m_alive = newAlive;
+  m_free = newFree;
+  m_capacity = capacity;
+}
+
+// Removes every boid in O(1), the memory is kept for the next flock
+template <int TILE>
+void BasicBoidStore<TILE>::clear() {
+  m_size = 0;
+  m_capacity = 0;
+  m_freeCount = 0;
+  m_arena.reset();
+  for (int c = 0; c < NUM_COLUMNS; c++) {
+    m_col[c] = NULL;
+  }
+  m_block = NULL;
+  m_alive = NULL;
+  m_free = NULL;
+}
+
+// Removes every boid and frees their memory
+template <int TILE>
+void BasicBoidStore<TILE>::release() {
+  clear();
+  m_arena.release();
+}
+
+// Adds a boid at rest with a mass of 1, returns its slot. The last slot that
+// was freed is used first. Its own parameters (PARAMS=1) are left for the
+// caller to set.
+template <int TILE>
+int BasicBoidStore<TILE>::add(Vec3f const &pos) {
+  int i;
+
+  if (m_freeCount > 0) {
+    i = m_free[--m_freeCount];
+  } else {
+    if (m_size == m_capacity) {
+      reserve(m_capacity > 0 ? 2 * m_capacity : 64);
+    }
+    i = m_size++;
+  }
+  m_alive[i] = 1;
+  setPosition(i, pos);
+  setVelocity(i, Vec3f(0.f, 0.f, 0.f));
+  setForce(i, Vec3f(0.f, 0.f, 0.f));
+  setMass(i, 1.f);
+  for (int c = KEPT_FX; c <= KEPT_FZ; c++) {
+    m_col[c][slot(i)] = 0.f;
+  }
+  return i;
+}
+
+// Frees the slot of boid i. It stays where it is, at rest and without force,
+// so the loops that don't check for dead slots leave it alone.
+template <int TILE>
+void BasicBoidStore<TILE>::remove(int i) {
+  if (!m_alive[i]) {
+    return;
+  }
+  m_alive[i] = 0;
+  setVelocity(i, Vec3f(0.f, 0.f, 0.f));
+  setForce(i, Vec3f(0.f, 0.f, 0.f));
+  for (int c = KEPT_FX; c <= KEPT_FZ; c++) {
+    m_col[c][slot(i)] = 0.f;
+  }
+  m_free[m_freeCount++] = i;
+}
+
+template <int TILE>
+void BasicBoidStore<TILE>::resetForces() {
+  for (int k = 0; k < tileCount(); k++) {
+    Tile t = tile(k);
+    for (int c = FX; c <= FZ; c++) {
+      memset(t.field(Column(c)), 0, sizeof(float) * t.count());
+    }
+  }
+}
+
+template <int TILE>
+void BasicBoidStore<TILE>::resetKeptForces() {
+  for (int k = 0; k < tileCount(); k++) {
+    Tile t = tile(k);
+    for (int c = KEPT_FX; c <= KEPT_FZ; c++) {
+      memset(t.field(Column(c)), 0, sizeof(float) * t.count());
+    }
+  }
+}
+
+// Makes the next state the current one, the old current state is what the
+// following step writes over
+template <int TILE>
+void BasicBoidStore<TILE>::swap() {
+  for (int c = PX; c <= VZ; c++) {
+    std::swap(m_col[c], m_col[c + NEXT_PX - PX]);
+  }
+}
+
+// Reorders the boids so the new boid i is the old boid order[i], keeping
+// only the count boids listed. They all have to be alive, so afterwards
+// there are no dead slots. The next state is skipped, every step writes all
+// of it before it is read, so it holds the old values while they are moved
+// and nothing has to be allocated.
+template <int TILE>
+void BasicBoidStore<TILE>::permute(int const *order, int count) {
+  float *old = m_col[NEXT_PX];
+
+  for (int c = 0; c < NUM_COLUMNS; c++) {
+    if (c >= NEXT_PX && c <= NEXT_VZ) {
+      continue;
+    }
+    float *column = m_col[c];
+    for (int i = 0; i < m_size; i++) {
+      old[slot(i)] = column[slot(i)];
+    }
+    for (int i = 0; i < count; i++) {
+      column[slot(i)] = old[slot(order[i])];
+    }
+  }
+  memset(m_alive, 1, count);
+  m_size = count;
+  m_freeCount = 0;
+}
+
+// Moves the live boids down over the dead slots, keeping their order.
+// order gets the old slot of every boid, like for permute.
+template <int TILE>
+void BasicBoidStore<TILE>::compact(vector<int> &order) {
+  order.clear();
+  for (int i = 0; i < m_size; i++) {
+    if (m_alive[i]) {
+      order.push_back(i);
+    }
+  }
+  permute(order.data(), int(order.size()));
+}
+
+// ==========================================================================//
+
+// only the layout picked with BOID_TILE is built
+template class BasicBoidStore<BOID_TILE>;
@@ -0,0 +1,67 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "CacheMissCounter.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// ======================== CONSTRUCTORS ============================//
+CacheMissCounter::CacheMissCounter() {
+  m_fd = -1;
+#ifdef __linux__
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // this thread, any cpu
+  m_fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter() {
+#ifdef __linux__
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+#endif
+}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+bool CacheMissCounter::available() const { return m_fd >= 0; }
+
+void CacheMissCounter::start() {
+#ifdef __linux__
+  if (m_fd >= 0) {
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+uint64_t CacheMissCounter::stop() {
+  uint64_t misses = 0;
+#ifdef __linux__
+  if (m_fd >= 0) {
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(m_fd, &misses, sizeof(misses)) != sizeof(misses)) {
+      misses = 0;
+    }
+  }
+#endif
+  return misses;
+}
+
+// ==========================================================================//
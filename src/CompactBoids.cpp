@@ -0,0 +1,93 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "CompactBoids.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ======================== CONSTRUCTORS ============================//
+CompactBoids::CompactBoids() {
+  m_positionStep = 1.f;
+  m_velocityStep = 1.f;
+}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+// Rounds value/step to the nearest short, saturating at +-QUANT_MAX
+short CompactBoids::quantize(float value, float invStep) {
+  float q = value * invStep;
+  q = std::min(std::max(q, -float(QUANT_MAX)), float(QUANT_MAX));
+  return short(std::lrint(q));
+}
+
+short CompactBoids::saturate(int q) {
+  return short(std::min(std::max(q, -int(QUANT_MAX)), int(QUANT_MAX)));
+}
+
+// Copies the state of every boid, positions must be within +-range and
+// speeds at most maxSpeed
+void CompactBoids::encode(BoidStore const &boids, float range,
+                          float maxSpeed) {
+  int numBoids = boids.size();
+  float const *px = boids.column(BoidStore::PX);
+  float const *py = boids.column(BoidStore::PY);
+  float const *pz = boids.column(BoidStore::PZ);
+  float const *vx = boids.column(BoidStore::VX);
+  float const *vy = boids.column(BoidStore::VY);
+  float const *vz = boids.column(BoidStore::VZ);
+
+  // with no room to move (V 0) every value is 0, any step will do
+  m_positionStep = range > 0.f ? range / QUANT_MAX : 1.f;
+  m_velocityStep = maxSpeed > 0.f ? maxSpeed / QUANT_MAX : 1.f;
+  float invPosition = 1.f / m_positionStep;
+  float invVelocity = 1.f / m_velocityStep;
+
+  m_qx.resize(numBoids);
+  m_qy.resize(numBoids);
+  m_qz.resize(numBoids);
+  m_qvx.resize(numBoids);
+  m_qvy.resize(numBoids);
+  m_qvz.resize(numBoids);
+  for (int i = 0; i < numBoids; i++) {
+    int s = BoidStore::slot(i);
+    m_qx[i] = quantize(px[s], invPosition);
+    m_qy[i] = quantize(py[s], invPosition);
+    m_qz[i] = quantize(pz[s], invPosition);
+    m_qvx[i] = quantize(vx[s], invVelocity);
+    m_qvy[i] = quantize(vy[s], invVelocity);
+    m_qvz[i] = quantize(vz[s], invVelocity);
+  }
+}
+
+// Writes the triangle of every live boid, three vertices of x, y, z each,
+// in the same steps as the positions. Drawn as normalized shorts, scaled by
+// range.
+void CompactBoids::geometry(unsigned char const *alive,
+                            vector<short> &out) const {
+  float inv = 1.f / m_positionStep;
+  // the nose 0.5 to the left, the tail 1 back and 0.5 up and down
+  int back = int(std::lrint(1.f * inv));
+  int half = int(std::lrint(0.5f * inv));
+  int offsetX[3] = {-half, back, back};
+  int offsetY[3] = {0, half, -half};
+
+  out.resize(9 * size());
+  short *v = out.data();
+  for (int i = 0; i < size(); i++) {
+    if (!alive[i]) {
+      continue;
+    }
+    for (int k = 0; k < 3; k++) {
+      v[0] = saturate(m_qx[i] + offsetX[k]);
+      v[1] = saturate(m_qy[i] + offsetY[k]);
+      v[2] = m_qz[i];
+      v += 3;
+    }
+  }
+  out.resize(v - out.data());
+}
+
+// ==========================================================================//
@@ -0,0 +1,73 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "FlockArena.h"
+#include "PageAllocator.h"
+
+#include <algorithm>
+
+// ======================== CONSTRUCTORS ============================//
+FlockArena::FlockArena() {
+  m_current = 0;
+  m_offset = 0;
+  m_used = 0;
+  m_reserved = 0;
+}
+
+FlockArena::~FlockArena() { release(); }
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+// Gives bytes of memory starting on an ALIGNMENT boundary, valid until the
+// next reset or release
+void *FlockArena::allocate(size_t bytes) {
+  bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+  // move on to a later block if the current one is full
+  while (m_current < m_blocks.size() &&
+         m_offset + bytes > m_blocks[m_current].size) {
+    m_current++;
+    m_offset = 0;
+  }
+
+  if (m_current == m_blocks.size()) {
+    // each new block at least doubles what the arena holds, big ones go
+    // on huge pages if setPageMode asked for them
+    Block block;
+    block.size = pageRound(max(bytes, max(size_t(MIN_BLOCK), m_reserved)));
+    block.data = static_cast<char *>(allocatePages(block.size, ALIGNMENT));
+    m_blocks.push_back(block);
+    m_reserved += block.size;
+    m_offset = 0;
+  }
+
+  void *piece = m_blocks[m_current].data + m_offset;
+  m_offset += bytes;
+  m_used += bytes;
+  return piece;
+}
+
+// Forgets everything handed out, the blocks stay for the next run
+void FlockArena::reset() {
+  m_current = 0;
+  m_offset = 0;
+  m_used = 0;
+}
+
+// Frees every block
+void FlockArena::release() {
+  for (size_t b = 0; b < m_blocks.size(); b++) {
+    freePages(m_blocks[b].data, m_blocks[b].size);
+  }
+  m_blocks.clear();
+  m_reserved = 0;
+  reset();
+}
+
+size_t FlockArena::used() const { return m_used; }
+
+size_t FlockArena::reserved() const { return m_reserved; }
+
+// ==========================================================================//
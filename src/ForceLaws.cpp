@@ -0,0 +1,56 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "ForceLaws.h"
+
+#include <cmath>
+
+// The laws of favoid and fgather in main.cpp for a weight of 1
+static double powAvoid(double r) { return pow((1 - r), 3) * (3 * r + 1); }
+
+static double powGather(double distance) {
+  if (distance <= 1) {
+    return 1.0;
+  }
+  return 1 / pow(distance, 2);
+}
+
+// ======================== CONSTRUCTORS ============================//
+ForceLaws::ForceLaws()
+    : m_mode(POW_LAWS), m_gatherRadius(0.f), m_gatherScale(0.f),
+      m_avoidError(0.f), m_gatherError(0.f) {}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void ForceLaws::build(ForceLawMode mode, float gatherRadius) {
+  m_mode = mode;
+  // below distance 1 gathering is flat, the table starts at the kink
+  m_gatherRadius = max(gatherRadius, 2.f);
+  m_gatherScale = TABLE_CELLS / (m_gatherRadius - 1.f);
+  m_avoid.resize(TABLE_CELLS + 1);
+  m_gather.resize(TABLE_CELLS + 1);
+  for (int k = 0; k <= TABLE_CELLS; k++) {
+    m_avoid[k] = float(powAvoid(double(k) / TABLE_CELLS));
+    m_gather[k] = float(powGather(1.0 + double(k) / m_gatherScale));
+  }
+
+  // check between and on the table entries, where interpolating is worst
+  // and best
+  m_avoidError = 0.f;
+  m_gatherError = 0.f;
+  if (mode == POW_LAWS) {
+    return;
+  }
+  const int SAMPLES = 16 * TABLE_CELLS;
+  for (int n = 0; n <= SAMPLES; n++) {
+    float r = float(n) / SAMPLES;
+    float distance = r * m_gatherRadius;
+    m_avoidError = max(m_avoidError, float(fabs(avoid(r) - powAvoid(r))));
+    m_gatherError = max(m_gatherError,
+                        float(fabs(gather(distance) - powGather(distance))));
+  }
+}
+
+// ==========================================================================//
@@ -0,0 +1,189 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "Integrator.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define INTEGRATOR_SSE 1
+#include <emmintrin.h>
+#else
+#define INTEGRATOR_SSE 0
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INTEGRATOR_AVX 1
+#include <immintrin.h>
+#else
+#define INTEGRATOR_AVX 0
+#endif
+
+// ========================= OPERATORS ======================================//
+// -limit <= v <= limit, picking the operands like maxps and minps do
+static inline float clampTo(float v, float limit) {
+  float low = -limit;
+  v = v > low ? v : low;
+  return v < limit ? v : limit;
+}
+
+static inline void bounce(float &p, float &v, float edge) {
+  if (p > edge) {
+    p = edge - 1;
+    v = -v;
+  } else if (p < -edge) {
+    p = -(edge - 1);
+    v = -v;
+  }
+}
+
+static void integrateLane(StepRun const &run, int l) {
+  float fmax = run.maxForce ? run.maxForce[l] : run.fmax;
+  float vmax = run.maxSpeed ? run.maxSpeed[l] : run.vmax;
+  float m = run.mass[l];
+  float vx = clampTo(run.vx[l] + (clampTo(run.fx[l], fmax) / m) * run.deltaT, vmax);
+  float vy = clampTo(run.vy[l] + (clampTo(run.fy[l], fmax) / m) * run.deltaT, vmax);
+  float vz = clampTo(run.vz[l] + (clampTo(run.fz[l], fmax) / m) * run.deltaT, vmax);
+  float px = run.px[l] + vx * run.deltaT;
+  float py = run.py[l] + vy * run.deltaT;
+  float pz = run.pz[l] + vz * run.deltaT;
+  bounce(px, vx, run.edge);
+  bounce(py, vy, run.edge);
+  bounce(pz, vz, run.edge);
+  run.nextVx[l] = vx;
+  run.nextVy[l] = vy;
+  run.nextVz[l] = vz;
+  run.nextPx[l] = px;
+  run.nextPy[l] = py;
+  run.nextPz[l] = pz;
+}
+
+void integrateScalar(StepRun const &run) {
+  for (int l = 0; l < run.count; l++) {
+    integrateLane(run, l);
+  }
+}
+
+#if INTEGRATOR_SSE
+// The vector versions follow integrateLane line by line. Negating flips
+// the sign bit like -v does, so -0 stays -0.
+
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 clamp4(__m128 v, __m128 limit, __m128 sign) {
+  return _mm_min_ps(_mm_max_ps(v, _mm_xor_ps(limit, sign)), limit);
+}
+
+// Position and velocity on one axis after the bounce
+static inline void bounce4(__m128 &p, __m128 &v, __m128 edge, __m128 back,
+                           __m128 sign) {
+  __m128 over = _mm_cmpgt_ps(p, edge);
+  __m128 under = _mm_cmplt_ps(p, _mm_xor_ps(edge, sign));
+  p = select4(over, back, select4(under, _mm_xor_ps(back, sign), p));
+  v = _mm_xor_ps(v, _mm_and_ps(_mm_or_ps(over, under), sign));
+}
+
+// Does the boids from first on in fours, returns where it stopped
+static int integrateSse(StepRun const &run, int first) {
+  __m128 sign = _mm_set1_ps(-0.f);
+  __m128 dt = _mm_set1_ps(run.deltaT);
+  __m128 edge = _mm_set1_ps(run.edge);
+  __m128 back = _mm_set1_ps(run.edge - 1); // where a boid is put back
+  int l = first;
+
+  for (; l + 4 <= run.count; l += 4) {
+    __m128 fmax = run.maxForce ? _mm_loadu_ps(run.maxForce + l) : _mm_set1_ps(run.fmax);
+    __m128 vmax = run.maxSpeed ? _mm_loadu_ps(run.maxSpeed + l) : _mm_set1_ps(run.vmax);
+    __m128 m = _mm_loadu_ps(run.mass + l);
+    __m128 vx = clamp4(_mm_add_ps(_mm_loadu_ps(run.vx + l), _mm_mul_ps(_mm_div_ps(clamp4(_mm_loadu_ps(run.fx + l), fmax, sign), m), dt)), vmax, sign);
+    __m128 vy = clamp4(_mm_add_ps(_mm_loadu_ps(run.vy + l), _mm_mul_ps(_mm_div_ps(clamp4(_mm_loadu_ps(run.fy + l), fmax, sign), m), dt)), vmax, sign);
+    __m128 vz = clamp4(_mm_add_ps(_mm_loadu_ps(run.vz + l), _mm_mul_ps(_mm_div_ps(clamp4(_mm_loadu_ps(run.fz + l), fmax, sign), m), dt)), vmax, sign);
+    __m128 px = _mm_add_ps(_mm_loadu_ps(run.px + l), _mm_mul_ps(vx, dt));
+    __m128 py = _mm_add_ps(_mm_loadu_ps(run.py + l), _mm_mul_ps(vy, dt));
+    __m128 pz = _mm_add_ps(_mm_loadu_ps(run.pz + l), _mm_mul_ps(vz, dt));
+    bounce4(px, vx, edge, back, sign);
+    bounce4(py, vy, edge, back, sign);
+    bounce4(pz, vz, edge, back, sign);
+    _mm_storeu_ps(run.nextVx + l, vx);
+    _mm_storeu_ps(run.nextVy + l, vy);
+    _mm_storeu_ps(run.nextVz + l, vz);
+    _mm_storeu_ps(run.nextPx + l, px);
+    _mm_storeu_ps(run.nextPy + l, py);
+    _mm_storeu_ps(run.nextPz + l, pz);
+  }
+  return l;
+}
+#endif
+
+#if INTEGRATOR_AVX
+__attribute__((target("avx"))) static inline __m256
+clamp8(__m256 v, __m256 limit, __m256 sign) {
+  return _mm256_min_ps(_mm256_max_ps(v, _mm256_xor_ps(limit, sign)), limit);
+}
+
+__attribute__((target("avx"))) static inline void
+bounce8(__m256 &p, __m256 &v, __m256 edge, __m256 back, __m256 sign) {
+  __m256 over = _mm256_cmp_ps(p, edge, _CMP_GT_OQ);
+  __m256 under = _mm256_cmp_ps(p, _mm256_xor_ps(edge, sign), _CMP_LT_OQ);
+  p = _mm256_blendv_ps(_mm256_blendv_ps(p, _mm256_xor_ps(back, sign), under),
+                       back, over);
+  v = _mm256_xor_ps(v, _mm256_and_ps(_mm256_or_ps(over, under), sign));
+}
+
+// Does the boids from first on in eights, returns where it stopped
+__attribute__((target("avx"))) static int integrateAvx(StepRun const &run,
+                                                       int first) {
+  __m256 sign = _mm256_set1_ps(-0.f);
+  __m256 dt = _mm256_set1_ps(run.deltaT);
+  __m256 edge = _mm256_set1_ps(run.edge);
+  __m256 back = _mm256_set1_ps(run.edge - 1); // where a boid is put back
+  int l = first;
+
+  for (; l + 8 <= run.count; l += 8) {
+    __m256 fmax = run.maxForce ? _mm256_loadu_ps(run.maxForce + l) : _mm256_set1_ps(run.fmax);
+    __m256 vmax = run.maxSpeed ? _mm256_loadu_ps(run.maxSpeed + l) : _mm256_set1_ps(run.vmax);
+    __m256 m = _mm256_loadu_ps(run.mass + l);
+    __m256 vx = clamp8(_mm256_add_ps(_mm256_loadu_ps(run.vx + l), _mm256_mul_ps(_mm256_div_ps(clamp8(_mm256_loadu_ps(run.fx + l), fmax, sign), m), dt)), vmax, sign);
+    __m256 vy = clamp8(_mm256_add_ps(_mm256_loadu_ps(run.vy + l), _mm256_mul_ps(_mm256_div_ps(clamp8(_mm256_loadu_ps(run.fy + l), fmax, sign), m), dt)), vmax, sign);
+    __m256 vz = clamp8(_mm256_add_ps(_mm256_loadu_ps(run.vz + l), _mm256_mul_ps(_mm256_div_ps(clamp8(_mm256_loadu_ps(run.fz + l), fmax, sign), m), dt)), vmax, sign);
+    __m256 px = _mm256_add_ps(_mm256_loadu_ps(run.px + l), _mm256_mul_ps(vx, dt));
+    __m256 py = _mm256_add_ps(_mm256_loadu_ps(run.py + l), _mm256_mul_ps(vy, dt));
+    __m256 pz = _mm256_add_ps(_mm256_loadu_ps(run.pz + l), _mm256_mul_ps(vz, dt));
+    bounce8(px, vx, edge, back, sign);
+    bounce8(py, vy, edge, back, sign);
+    bounce8(pz, vz, edge, back, sign);
+    _mm256_storeu_ps(run.nextVx + l, vx);
+    _mm256_storeu_ps(run.nextVy + l, vy);
+    _mm256_storeu_ps(run.nextVz + l, vz);
+    _mm256_storeu_ps(run.nextPx + l, px);
+    _mm256_storeu_ps(run.nextPy + l, py);
+    _mm256_storeu_ps(run.nextPz + l, pz);
+  }
+  return l;
+}
+
+static bool cpuHasAvx() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx");
+}
+#endif
+
+void integrateVector(StepRun const &run) {
+  int done = 0;
+#if INTEGRATOR_AVX
+  static const bool avx = cpuHasAvx();
+  if (avx) {
+    done = integrateAvx(run, done);
+  }
+#endif
+#if INTEGRATOR_SSE
+  done = integrateSse(run, done);
+#endif
+  for (int l = done; l < run.count; l++) {
+    integrateLane(run, l);
+  }
+}
+
+// ==========================================================================//
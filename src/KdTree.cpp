@@ -0,0 +1,256 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "KdTree.h"
+
+#include <algorithm>
+
+// Orders boid indices by one coordinate, for nth_element
+struct AxisLess {
+  vector<Vec3f> const *points;
+  int axis;
+  bool operator()(int a, int b) const {
+    return (*points)[a][axis] < (*points)[b][axis];
+  }
+};
+
+// ======================== CONSTRUCTORS ============================//
+KdTree::KdTree() {
+  m_k = 0;
+  m_parts = 0;
+  m_out = NULL;
+}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void KdTree::build(BoidStore const &boids, int numThreads) {
+  int numBoids = boids.size();
+
+  m_points.resize(numBoids);
+  m_index.resize(numBoids);
+  m_axis.assign(numBoids, 0);
+  for (int i = 0; i < numBoids; i++) {
+    m_index[i] = i;
+    m_points[i] = boids.position(i);
+  }
+
+  // the top levels are split one level at a time, each range of a level
+  // on its own thread, until there is a subtree for every thread
+  m_pool.resize(numThreads);
+  m_ranges.assign(1, make_pair(0, numBoids));
+  while (!m_ranges.empty() && int(m_ranges.size()) < m_pool.size()) {
+    m_splits.resize(m_ranges.size());
+    m_pool.run(splitJob, this, int(m_ranges.size()));
+    m_nextRanges.clear();
+    for (size_t r = 0; r < m_ranges.size(); r++) {
+      if (m_splits[r] >= 0) {
+        m_nextRanges.push_back(make_pair(m_ranges[r].first, m_splits[r]));
+        m_nextRanges.push_back(make_pair(m_splits[r] + 1, m_ranges[r].second));
+      }
+    }
+    m_ranges.swap(m_nextRanges);
+  }
+  // the subtrees don't overlap, so they can be built at the same time
+  m_pool.run(buildJob, this, int(m_ranges.size()));
+
+  // store the positions in tree order, so searching reads them in sequence
+  for (int t = 0; t < numBoids; t++) {
+    m_points[t] = boids.position(m_index[t]);
+  }
+}
+
+// k nearest of every boid, out[i * k + n] is the n-th nearest of boid i,
+// or -1 if there are not k other boids
+void KdTree::allNearest(int k, int numThreads, vector<int> &out) {
+  int numBoids = int(m_index.size());
+
+  out.assign(size_t(numBoids) * k, -1);
+  m_pool.resize(numThreads);
+  m_k = k;
+  m_out = out.data();
+  m_parts = max(1, min(m_pool.size(), numBoids / 256 + 1));
+  m_bestDist.resize(size_t(m_parts) * k);
+  m_pool.run(nearestJob, this, m_parts);
+}
+
+// Pairs every boid with its k nearest, each pair is only stored once
+// under its lower numbered boid
+void KdTree::buildPairs(int k, int numThreads) {
+  int numBoids = int(m_index.size());
+  int i;
+  int n;
+
+  allNearest(k, numThreads, m_nearest);
+
+  // count, prefix sum and fill, like a counting sort
+  m_start.assign(numBoids + 1, 0);
+  for (i = 0; i < numBoids; i++) {
+    for (n = 0; n < k; n++) {
+      int j = m_nearest[size_t(i) * k + n];
+      if (j >= 0) {
+        m_start[min(i, j) + 1]++;
+      }
+    }
+  }
+  for (i = 0; i < numBoids; i++) {
+    m_start[i + 1] += m_start[i];
+  }
+  m_next.assign(m_start.begin(), m_start.end() - 1);
+  // room for the most pairs there can be, so later steps don't grow it
+  m_pairs.reserve(size_t(numBoids) * k);
+  m_pairs.resize(m_start[numBoids]);
+  for (i = 0; i < numBoids; i++) {
+    for (n = 0; n < k; n++) {
+      int j = m_nearest[size_t(i) * k + n];
+      if (j >= 0) {
+        m_pairs[m_next[min(i, j)]++] = max(i, j);
+      }
+    }
+  }
+
+  // boids that are in each other's k nearest show up twice, drop one
+  int kept = 0;
+  for (i = 0; i < numBoids; i++) {
+    int first = m_start[i];
+    int last = m_start[i + 1];
+    sort(m_pairs.begin() + first, m_pairs.begin() + last);
+    m_start[i] = kept;
+    for (n = first; n < last; n++) {
+      if (n == first || m_pairs[n] != m_pairs[n - 1]) {
+        m_pairs[kept++] = m_pairs[n];
+      }
+    }
+  }
+  m_start[numBoids] = kept;
+  m_pairs.resize(kept);
+}
+
+// Gives the boids j > i that boid i is paired with
+void KdTree::neighbours(int i, vector<int> &out) const {
+  out.assign(m_pairs.begin() + m_start[i], m_pairs.begin() + m_start[i + 1]);
+}
+
+// Searches for the boids in tree positions [first, last), which keeps
+// neighbouring searches walking the same part of the tree
+void KdTree::nearestRange(int first, int last, int k, int *out,
+                          float *bestDist) const {
+  for (int t = first; t < last; t++) {
+    int i = m_index[t];
+    int found = 0;
+    search(0, int(m_index.size()), m_points[t], i, k, out + size_t(i) * k,
+           bestDist, found);
+  }
+}
+
+// Splits [lo, hi) at its middle along its widest axis and gives the
+// middle, or -1 if the range is a leaf
+int KdTree::splitRange(int lo, int hi) {
+  if (hi - lo <= LEAF_SIZE) {
+    return -1;
+  }
+
+  // split along the widest axis of the range
+  Vec3f low = m_points[m_index[lo]];
+  Vec3f high = low;
+  for (int t = lo + 1; t < hi; t++) {
+    Vec3f const &p = m_points[m_index[t]];
+    for (int a = 0; a < 3; a++) {
+      low[a] = min(low[a], p[a]);
+      high[a] = max(high[a], p[a]);
+    }
+  }
+  Vec3f extent = high - low;
+  int axis = 0;
+  if (extent.y() > extent[axis]) {
+    axis = 1;
+  }
+  if (extent.z() > extent[axis]) {
+    axis = 2;
+  }
+
+  int mid = (lo + hi) / 2;
+  AxisLess less = {&m_points, axis};
+  nth_element(m_index.begin() + lo, m_index.begin() + mid,
+              m_index.begin() + hi, less);
+  m_axis[mid] = char(axis);
+  return mid;
+}
+
+void KdTree::buildRange(int lo, int hi) {
+  int mid = splitRange(lo, hi);
+  if (mid >= 0) {
+    buildRange(lo, mid);
+    buildRange(mid + 1, hi);
+  }
+}
+
+void KdTree::splitJob(void *tree, int part) {
+  KdTree *t = static_cast<KdTree *>(tree);
+  t->m_splits[part] = t->splitRange(t->m_ranges[part].first,
+                                    t->m_ranges[part].second);
+}
+
+void KdTree::buildJob(void *tree, int part) {
+  KdTree *t = static_cast<KdTree *>(tree);
+  t->buildRange(t->m_ranges[part].first, t->m_ranges[part].second);
+}
+
+// Part p of m_parts searches for an equal run of the tree positions
+void KdTree::nearestJob(void *tree, int part) {
+  KdTree *t = static_cast<KdTree *>(tree);
+  int numBoids = int(t->m_index.size());
+  int per = (numBoids + t->m_parts - 1) / t->m_parts;
+  t->nearestRange(min(part * per, numBoids), min((part + 1) * per, numBoids),
+                  t->m_k, t->m_out, t->m_bestDist.data() + size_t(part) * t->m_k);
+}
+
+// best/bestDist hold the closest boids found so far, sorted by distance
+void KdTree::search(int lo, int hi, Vec3f const &pos, int self, int k,
+                    int *best, float *bestDist, int &found) const {
+  if (hi - lo <= LEAF_SIZE) {
+    for (int t = lo; t < hi; t++) {
+      if (m_index[t] == self) {
+        continue;
+      }
+      float d2 = (m_points[t] - pos).lengthSquared();
+      if (found == k && d2 >= bestDist[k - 1]) {
+        continue;
+      }
+      // insertion into the sorted list
+      int n = found < k ? found++ : k - 1;
+      while (n > 0 && bestDist[n - 1] > d2) {
+        bestDist[n] = bestDist[n - 1];
+        best[n] = best[n - 1];
+        n--;
+      }
+      bestDist[n] = d2;
+      best[n] = m_index[t];
+    }
+    return;
+  }
+
+  int mid = (lo + hi) / 2;
+  int axis = m_axis[mid];
+  float diff = pos[axis] - m_points[mid][axis];
+
+  // the middle element itself
+  search(mid, mid + 1, pos, self, k, best, bestDist, found);
+
+  // go down the side pos is on first, the other side only if it can
+  // still hold something closer
+  if (diff < 0.f) {
+    search(lo, mid, pos, self, k, best, bestDist, found);
+    if (found < k || diff * diff < bestDist[k - 1]) {
+      search(mid + 1, hi, pos, self, k, best, bestDist, found);
+    }
+  } else {
+    search(mid + 1, hi, pos, self, k, best, bestDist, found);
+    if (found < k || diff * diff < bestDist[k - 1]) {
+      search(lo, mid, pos, self, k, best, bestDist, found);
+    }
+  }
+}
+
+// ==========================================================================//
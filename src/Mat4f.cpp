@@ -12,85 +12,34 @@
 
 #include "Mat4f.h"
 
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Mat4f>::value,
+              "Mat4f is copied around by value, keep it a plain block");
+static_assert(sizeof(Mat4f) == Mat4f::NUM_ELEM * sizeof(float),
+              "Mat4f should hold nothing but its elements");
+
 // ====== CONSTRUCTORS (MOVE/COPY) / DESTRUCTORS ============================//
-Mat4f::Mat4f() {
-  Mat4fHandle tmp(new ARRAY_16f);
-  m_ptr = std::move(tmp); // take ownership
-}
+Mat4f::Mat4f() {}
 
-Mat4f::Mat4f(float t) {
-  Mat4fHandle tmp(new ARRAY_16f);
-  tmp->fill(t);
-  m_ptr = std::move(tmp); // take ownership
-}
+Mat4f::Mat4f(float t) { m_data.fill(t); }
 
 Mat4f::Mat4f(std::initializer_list<float> list) {
   assert(list.size() == NUM_ELEM);
-  Mat4fHandle tmp(new ARRAY_16f);
-  std::copy_n(list.begin(),  // source
-              NUM_ELEM,      // number of copies
-              tmp->begin()); // destination
-
-  m_ptr = std::move(tmp); // take ownership
-}
-
-Mat4f::Mat4f(Mat4f &&moved) {
-  m_ptr = std::move(moved.m_ptr); // take ownership
-}
-
-Mat4f::Mat4f(const Mat4f &copied) {
-  Mat4fHandle tmp(new ARRAY_16f);
-  std::copy_n(copied.begin(), // source
-              NUM_ELEM,       // number of copies
-              tmp->begin());  // destination
-
-  m_ptr = std::move(tmp); // take ownership
+  std::copy_n(list.begin(),    // source
+              NUM_ELEM,        // number of copies
+              m_data.begin()); // destination
 }
-
-Mat4f::~Mat4f() {}
 // ==========================================================================//
 
 // =========== OPERATORS ====================================================//
 
-Mat4f &Mat4f::operator=(const Mat4f &copied) {
-  if (this != &copied) {
-    Mat4f tmp(copied);
-    *this = std::move(tmp);
-  }
-  return *this;
-}
-
-Mat4f &Mat4f::operator=(Mat4f &&moved) {
-  m_ptr = std::move(moved.m_ptr);
-  return *this;
-}
-
-float &Mat4f::operator()(int row, int column) {
-  assert(isValidDimIndex(row) && isValidDimIndex(column));
-  return m_ptr->at(row * DIM + column);
-}
-
-float Mat4f::operator()(int row, int column) const {
-  assert(isValidDimIndex(row) && isValidDimIndex(column));
-  return m_ptr->at(row * DIM + column);
-}
-
-float &Mat4f::operator[](int element) {
-  assert(isValidElementIndex(element));
-  return m_ptr->at(element);
-}
-
-float Mat4f::operator[](int element) const {
-  assert(isValidElementIndex(element));
-  return m_ptr->at(element);
-}
-
 Mat4f Mat4f::operator+(Mat4f other) const {
   /* School Computers GCC doesn't support lambda funcs
-  std::transform(	m_ptr->begin(),
-                  m_ptr->end(),
-                  other.m_ptr->begin(),
-                  other.m_ptr->begin(),
+  std::transform(	m_data.begin(),
+                  m_data.end(),
+                  other.m_data.begin(),
+                  other.m_data.begin(),
                   []( float left, float right )
                   {
                           return left + right;
@@ -98,8 +47,8 @@ Mat4f Mat4f::operator+(Mat4f other) const {
           );
   */
 
-  std::transform(m_ptr->begin(), m_ptr->end(), other.m_ptr->begin(),
-                 other.m_ptr->begin(), std::plus<float>());
+  std::transform(m_data.begin(), m_data.end(), other.m_data.begin(),
+                 other.m_data.begin(), std::plus<float>());
   return other;
 }
 
@@ -111,9 +60,9 @@ Mat4f Mat4f::operator*(const Mat4f &other) const {
     for (int j = 0; j < DIM; ++j) {
       element = 0;
       for (int k = 0; k < DIM; ++k) {
-        element += (*this)(i, k) * other(k, j);
+        element += m_data[i * DIM + k] * other.m_data[k * DIM + j];
       }
-      result(i, j) = element;
+      result.m_data[i * DIM + j] = element;
     }
   }
 
@@ -123,9 +72,9 @@ Mat4f Mat4f::operator*(const Mat4f &other) const {
 Mat4f Mat4f::operator*(float scalar) const {
   Mat4f result(*this);
   /*
-  std::transform( result.m_ptr->begin(),
-                  result.m_ptr->end(),
-                  result.m_ptr->begin(),
+  std::transform( result.m_data.begin(),
+                  result.m_data.end(),
+                  result.m_data.begin(),
                   [ &scalar ]( float f )
                   {
                           return f*scalar;
@@ -170,25 +119,10 @@ Mat4f Mat4f::transposed() const {
   return result;
 }
 
-void Mat4f::fill(float t) { m_ptr->fill(t); }
+void Mat4f::fill(float t) { m_data.fill(t); }
 
 // ==========================================================================//
 
-float const *Mat4f::data() const { return m_ptr->data(); }
-
-Mat4f::ARRAY_16f::iterator Mat4f::begin() { return m_ptr->begin(); }
-
-Mat4f::ARRAY_16f::iterator Mat4f::end() { return m_ptr->end(); }
-
-Mat4f::ARRAY_16f::const_iterator Mat4f::begin() const { return m_ptr->begin(); }
-
-Mat4f::ARRAY_16f::const_iterator Mat4f::end() const { return m_ptr->end(); }
-
-bool Mat4f::isValidDimIndex(int idx) const { return idx >= 0 && idx < DIM; }
-bool Mat4f::isValidElementIndex(int idx) const {
-  return idx >= 0 && idx < NUM_ELEM;
-}
-
 std::ostream &operator<<(std::ostream &out, const Mat4f &mat) {
   std::ostream_iterator<float> out_it(out, " ");
   std::copy(mat.begin(), mat.end(), out_it);
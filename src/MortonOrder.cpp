@@ -0,0 +1,60 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "MortonOrder.h"
+
+#include <algorithm>
+#include <utility>
+
+// Spreads the low 10 bits of v out so there are two zero bits between each
+static uint32_t spreadBits(uint32_t v) {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+uint32_t mortonCode(uint32_t x, uint32_t y, uint32_t z) {
+  return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+// Cells past the 1024 that fit in a code (or outside the box) are clamped,
+// that only makes the order a bit less local, never wrong
+static uint32_t mortonCoord(float value, float cellSize, float edge) {
+  float c = floor((value + edge) / cellSize);
+  if (c < 0.f) {
+    return 0;
+  } else if (c > 1023.f) {
+    return 1023;
+  }
+  return uint32_t(c);
+}
+
+void mortonOrder(BoidStore const &boids, float cellSize, float edge,
+                 vector<int> &order, vector<pair<uint32_t, int> > &keys) {
+  if (cellSize <= 0.f) {
+    cellSize = 1.f;
+  }
+  keys.clear();
+  for (int i = 0; i < boids.size(); i++) {
+    if (!boids.isAlive(i)) {
+      continue;
+    }
+    Vec3f pos = boids.position(i);
+    keys.push_back(make_pair(mortonCode(mortonCoord(pos.x(), cellSize, edge),
+                                        mortonCoord(pos.y(), cellSize, edge),
+                                        mortonCoord(pos.z(), cellSize, edge)),
+                             i));
+  }
+  // the index breaks ties, so boids in the same cell keep their order
+  sort(keys.begin(), keys.end());
+
+  order.resize(keys.size());
+  for (int i = 0; i < int(keys.size()); i++) {
+    order[i] = keys[i].second;
+  }
+}
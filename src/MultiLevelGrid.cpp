@@ -0,0 +1,33 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "MultiLevelGrid.h"
+
+// ======================== CONSTRUCTORS ============================//
+MultiLevelGrid::MultiLevelGrid() {}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void MultiLevelGrid::buildFine(BoidStore const &boids, float cellSize,
+                               float edge) {
+  m_fine.build(boids, cellSize, edge);
+}
+
+void MultiLevelGrid::buildCoarse(BoidStore const &boids,
+                                 float cellSize, float edge) {
+  m_coarse.build(boids, cellSize, edge);
+}
+
+// Pairs that might be closer than the fine cell size, each given once
+void MultiLevelGrid::fineHalfShell(int i, vector<int> &out) const {
+  m_fine.halfShell(i, out);
+}
+
+// Pairs that might be closer than the coarse cell size, each given once
+void MultiLevelGrid::coarseHalfShell(int i, vector<int> &out) const {
+  m_coarse.halfShell(i, out);
+}
+
+// ==========================================================================//
@@ -0,0 +1,324 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "Octree.h"
+
+// Most nodes the tree can ever need for numBoids boids. Every branch holds
+// more than MERGE boids (it would be folded otherwise) and the branches at
+// one depth don't share any, so there are at most numBoids / (MERGE + 1) of
+// them, and 8^depth, at each depth a leaf can be split at. Each branch has
+// a block of eight children.
+static size_t maxNodes(int numBoids) {
+  size_t branches = 0;
+  size_t perDepth = 1;
+  size_t crowded = size_t(numBoids) / (Octree::MERGE + 1);
+  for (int depth = 0; depth < Octree::MAX_DEPTH; depth++) {
+    branches += min(perDepth, crowded);
+    perDepth = min(perDepth * 8, crowded + 1);
+  }
+  return 1 + 8 * branches;
+}
+
+// ======================== CONSTRUCTORS ============================//
+Octree::Octree() { m_valid = false; }
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void Octree::build(BoidStore const &boids, float edge) {
+  int numBoids = boids.size();
+  float extent = edge;
+
+  // boids can start outside the box, so make sure the root holds them all
+  m_pos.resize(numBoids);
+  for (int i = 0; i < numBoids; i++) {
+    m_pos[i] = boids.position(i);
+    for (int k = 0; k < 3; k++) {
+      extent = max(extent, std::abs(m_pos[i][k]));
+    }
+  }
+
+  Node root;
+  root.centre = Vec3f(0.f, 0.f, 0.f);
+  root.half = extent * 1.001f + 0.001f;
+  root.parent = -1;
+  root.firstChild = -1;
+  root.count = 0;
+  root.head = -1;
+  root.depth = 0;
+
+  m_nodes.assign(1, root);
+  // room for the most splits there can be, so update() never has to grow
+  // it however the flock gathers
+  size_t nodes = maxNodes(numBoids);
+  m_nodes.reserve(nodes);
+  m_freeChildren.clear();
+  m_freeChildren.reserve(nodes / 8);
+  m_stack.reserve(7 * MAX_DEPTH + 8);
+  m_leaf.assign(numBoids, -1);
+  m_next.assign(numBoids, -1);
+  m_prev.assign(numBoids, -1);
+
+  // dead slots are left out until a spawn files them with update()
+  for (int i = 0; i < numBoids; i++) {
+    if (boids.isAlive(i)) {
+      insert(i);
+    }
+  }
+  m_valid = true;
+}
+
+bool Octree::isValid(int numBoids) const {
+  return m_valid && numBoids == int(m_pos.size());
+}
+
+// Forces a rebuild, needed when the boids are renumbered
+void Octree::clear() { m_valid = false; }
+
+// Moves boid i to its new position, only touching the tree if it left its
+// leaf. A boid that isn't filed (a dead slot taken over by a spawn) is
+// filed at pos. A boid leaving the root cube, or past the slots the tree
+// was built for, marks the tree for a rebuild.
+void Octree::update(int i, Vec3f const &pos) {
+  if (!m_valid) {
+    return;
+  }
+  if (i >= int(m_pos.size())) {
+    m_valid = false;
+    return;
+  }
+
+  m_pos[i] = pos;
+  int oldLeaf = m_leaf[i];
+  if (oldLeaf >= 0 && contains(m_nodes[oldLeaf], pos)) {
+    return;
+  }
+  if (!contains(m_nodes[0], pos)) {
+    m_valid = false;
+    return;
+  }
+
+  if (oldLeaf >= 0) {
+    remove(i);
+  }
+  insert(i);
+  if (oldLeaf >= 0) {
+    foldAbove(oldLeaf);
+  }
+}
+
+// Takes boid i out of the tree, for a boid that is removed from the flock
+void Octree::erase(int i) {
+  if (!m_valid || i >= int(m_pos.size()) || m_leaf[i] < 0) {
+    return;
+  }
+
+  int oldLeaf = m_leaf[i];
+  remove(i);
+  foldAbove(oldLeaf);
+}
+
+// Gives every boid closer than radius to pos
+void Octree::query(Vec3f const &pos, float radius, vector<int> &out) const {
+  float r2 = radius * radius;
+
+  out.clear();
+  m_stack.assign(1, 0);
+  while (!m_stack.empty()) {
+    Node const &node = m_nodes[m_stack.back()];
+    m_stack.pop_back();
+    if (node.count == 0) {
+      continue;
+    }
+
+    // squared distance from pos to the closest point of the cube
+    float d2 = 0.f;
+    for (int k = 0; k < 3; k++) {
+      float d = std::abs(pos[k] - node.centre[k]) - node.half;
+      if (d > 0.f) {
+        d2 += d * d;
+      }
+    }
+    if (d2 >= r2) {
+      continue;
+    }
+
+    if (node.firstChild < 0) {
+      for (int j = node.head; j >= 0; j = m_next[j]) {
+        if ((m_pos[j] - pos).lengthSquared() < r2) {
+          out.push_back(j);
+        }
+      }
+    } else {
+      for (int c = 0; c < 8; c++) {
+        m_stack.push_back(node.firstChild + c);
+      }
+    }
+  }
+}
+
+// Gives every boid closer than radius to boid i (including i itself)
+void Octree::neighbours(int i, float radius, vector<int> &out) const {
+  query(m_pos[i], radius, out);
+}
+
+int Octree::leafCount() const {
+  int leaves = 0;
+  for (int n = 0; n < int(m_nodes.size()); n++) {
+    if (m_nodes[n].firstChild < 0 && m_nodes[n].depth >= 0) {
+      leaves++;
+    }
+  }
+  return leaves;
+}
+
+int Octree::childFor(Node const &node, Vec3f const &pos) const {
+  return (pos.x() >= node.centre.x() ? 1 : 0) |
+         (pos.y() >= node.centre.y() ? 2 : 0) |
+         (pos.z() >= node.centre.z() ? 4 : 0);
+}
+
+// Same half open rule as childFor, so a boid inside a leaf's cube would be
+// sent to that leaf when walking down from the root
+bool Octree::contains(Node const &node, Vec3f const &pos) const {
+  for (int k = 0; k < 3; k++) {
+    if (pos[k] < node.centre[k] - node.half ||
+        pos[k] >= node.centre[k] + node.half) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Octree::insert(int i) {
+  int node = 0;
+
+  m_nodes[node].count++;
+  while (m_nodes[node].firstChild >= 0) {
+    node = m_nodes[node].firstChild + childFor(m_nodes[node], m_pos[i]);
+    m_nodes[node].count++;
+  }
+  link(node, i);
+
+  if (m_nodes[node].count > SPLIT && m_nodes[node].depth < MAX_DEPTH) {
+    split(node);
+  }
+}
+
+void Octree::remove(int i) {
+  int leaf = m_leaf[i];
+
+  if (m_prev[i] >= 0) {
+    m_next[m_prev[i]] = m_next[i];
+  } else {
+    m_nodes[leaf].head = m_next[i];
+  }
+  if (m_next[i] >= 0) {
+    m_prev[m_next[i]] = m_prev[i];
+  }
+  m_leaf[i] = -1;
+
+  for (int node = leaf; node >= 0; node = m_nodes[node].parent) {
+    m_nodes[node].count--;
+  }
+}
+
+// Folds the highest branch above leaf that became sparse
+void Octree::foldAbove(int leaf) {
+  int sparse = -1;
+  for (int node = m_nodes[leaf].parent; node >= 0;
+       node = m_nodes[node].parent) {
+    if (m_nodes[node].count <= MERGE) {
+      sparse = node;
+    }
+  }
+  if (sparse >= 0) {
+    collapse(sparse);
+  }
+}
+
+// Puts boid i at the front of a leaf's list (counts are done by the caller)
+void Octree::link(int node, int i) {
+  m_prev[i] = -1;
+  m_next[i] = m_nodes[node].head;
+  if (m_nodes[node].head >= 0) {
+    m_prev[m_nodes[node].head] = i;
+  }
+  m_nodes[node].head = i;
+  m_leaf[i] = node;
+}
+
+void Octree::split(int node) {
+  int first = allocChildren();
+  float quarter = m_nodes[node].half * 0.5f;
+
+  for (int c = 0; c < 8; c++) {
+    Node &child = m_nodes[first + c];
+    child.centre = m_nodes[node].centre +
+                   Vec3f((c & 1) ? quarter : -quarter,
+                         (c & 2) ? quarter : -quarter,
+                         (c & 4) ? quarter : -quarter);
+    child.half = quarter;
+    child.parent = node;
+    child.firstChild = -1;
+    child.count = 0;
+    child.head = -1;
+    child.depth = m_nodes[node].depth + 1;
+  }
+
+  // hand the boids down to the children
+  int i = m_nodes[node].head;
+  m_nodes[node].head = -1;
+  m_nodes[node].firstChild = first;
+  while (i >= 0) {
+    int next = m_next[i];
+    int child = first + childFor(m_nodes[node], m_pos[i]);
+    m_nodes[child].count++;
+    link(child, i);
+    i = next;
+  }
+
+  // a tight cluster can land in a single child, keep going down
+  for (int c = 0; c < 8; c++) {
+    if (m_nodes[first + c].count > SPLIT &&
+        m_nodes[first + c].depth < MAX_DEPTH) {
+      split(first + c);
+    }
+  }
+}
+
+// Turns a branch back into a single leaf holding all its boids
+void Octree::collapse(int node) {
+  int first = m_nodes[node].firstChild;
+  if (first < 0) {
+    return;
+  }
+
+  m_nodes[node].firstChild = -1;
+  m_nodes[node].head = -1;
+  for (int c = 0; c < 8; c++) {
+    collapse(first + c);
+    int i = m_nodes[first + c].head;
+    while (i >= 0) {
+      int next = m_next[i];
+      link(node, i);
+      i = next;
+    }
+    m_nodes[first + c].depth = -1; // marks the block as unused
+  }
+  m_freeChildren.push_back(first);
+}
+
+int Octree::allocChildren() {
+  if (!m_freeChildren.empty()) {
+    int first = m_freeChildren.back();
+    m_freeChildren.pop_back();
+    return first;
+  }
+  int first = int(m_nodes.size());
+  m_nodes.resize(m_nodes.size() + 8);
+  return first;
+}
+
+// ==========================================================================//
@@ -0,0 +1,122 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "PageAllocator.h"
+#include "AllocationAudit.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
+
+#ifdef __linux__
+#include <stdint.h>
+#include <sys/mman.h>
+#endif
+
+static PageMode g_pageMode = NORMAL_PAGES;
+static size_t g_fallbacks = 0;
+
+// ========================= OPERATORS ======================================//
+// Picks the pages for the large mappings made from now on
+void setPageMode(PageMode mode) { g_pageMode = mode; }
+
+PageMode pageMode() { return g_pageMode; }
+
+size_t pageFallbacks() { return g_fallbacks; }
+
+// Size that is really mapped for bytes, large pieces are whole huge pages
+size_t pageRound(size_t bytes) {
+  if (bytes < size_t(LARGE_SIZE)) {
+    return bytes;
+  }
+  return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+#ifdef __linux__
+// Maps bytes (whole huge pages) starting on a huge page boundary, so the
+// kernel can back all of it with huge pages
+static void *mapAligned(size_t bytes) {
+  size_t extra = HUGE_PAGE_SIZE;
+  void *raw = mmap(NULL, bytes + extra, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return NULL;
+  }
+  // give back what is before the boundary and after the end
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  if (start + extra > aligned) {
+    munmap(reinterpret_cast<void *>(aligned + bytes), start + extra - aligned);
+  }
+  return reinterpret_cast<void *>(aligned);
+}
+
+static void *mapHugetlb(size_t bytes) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+  flags |= 21 << MAP_HUGE_SHIFT; // 2MB pages, whatever the default size is
+#endif
+  void *data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return data == MAP_FAILED ? NULL : data;
+}
+#endif
+
+// Gives bytes of memory starting on an alignment boundary (at most a page
+// for large pieces), throws bad_alloc when there is none at all
+void *allocatePages(size_t bytes, size_t alignment) {
+  void *data = NULL;
+
+#ifdef __linux__
+  if (bytes >= size_t(LARGE_SIZE)) {
+    bytes = pageRound(bytes);
+    notePageAllocation();
+    PageMode got = g_pageMode;
+    if (got == HUGETLB_PAGES) {
+      data = mapHugetlb(bytes);
+      if (data == NULL) {
+        got = TRANSPARENT_HUGE_PAGES;
+      }
+    }
+    if (data == NULL) {
+      data = mapAligned(bytes);
+      if (data == NULL) {
+        throw std::bad_alloc();
+      }
+      if (got == TRANSPARENT_HUGE_PAGES &&
+          madvise(data, bytes, MADV_HUGEPAGE) != 0) {
+        got = NORMAL_PAGES;
+      }
+    }
+    if (got != g_pageMode) {
+      g_fallbacks++;
+    }
+    return data;
+  }
+#endif
+  alignment = max(alignment, sizeof(void *));
+  if (posix_memalign(&data, alignment, max(bytes, size_t(1))) != 0) {
+    throw std::bad_alloc();
+  }
+  return data;
+}
+
+// Frees what allocatePages gave for the same number of bytes
+void freePages(void *data, size_t bytes) {
+  if (data == NULL) {
+    return;
+  }
+#ifdef __linux__
+  if (bytes >= size_t(LARGE_SIZE)) {
+    munmap(data, pageRound(bytes));
+    return;
+  }
+#endif
+  free(data);
+}
+
+// ==========================================================================//
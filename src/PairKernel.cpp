@@ -0,0 +1,405 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "PairKernel.h"
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PAIR_KERNEL_AVX 1
+#include <immintrin.h>
+#else
+#define PAIR_KERNEL_AVX 0
+#endif
+
+#if PAIR_KERNEL_AVX
+static_assert(BOID_TILE == 0 || BOID_TILE == 8 || BOID_TILE == 16,
+              "the kernels work out the slots of tiles of 8 or 16 boids");
+enum { TILE_SHIFT = BOID_TILE == 16 ? 4 : 3 };
+#endif
+
+// ========================= OPERATORS ======================================//
+PairKernel bestPairKernel() {
+#if PAIR_KERNEL_AVX
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return AVX512_PAIRS;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return AVX2_PAIRS;
+  }
+#endif
+  return SCALAR_PAIRS;
+}
+
+char const *pairKernelName(PairKernel kernel) {
+  switch (kernel) {
+  case AVX512_PAIRS:
+    return "AVX-512";
+  case AVX2_PAIRS:
+    return "AVX2";
+  default:
+    return "scalar";
+  }
+}
+
+#if PAIR_KERNEL_AVX
+// Everything below is built for AVX2 or AVX-512 only. Plain SSE code called
+// in between would cost a change of state on every call.
+
+// Drops the lanes in bits whose partner is dead. Only the few lanes that
+// are in range get looked up.
+__attribute__((target("avx2"))) static int
+dropDead(PairJob const &job, int const *partners, int bits) {
+  int left = bits;
+  while (left != 0) {
+    int l = __builtin_ctz(left);
+    left &= left - 1;
+    if (!job.alive[partners[l]]) {
+      bits &= ~(1 << l);
+    }
+  }
+  return bits;
+}
+
+// Writes out what the vector part found for one batch: the force on every
+// partner in forceBits and the cohesion sums of both boids for every
+// partner in cohesionBits, in partner order like the scalar loop
+__attribute__((target("avx2"))) static void
+applyLanes(PairJob const &job, int i, int si, int const *partners,
+           int const *slots, int forceBits, int cohesionBits, float const *fx,
+           float const *fy, float const *fz, float const *dist) {
+  while (forceBits != 0) {
+    int l = __builtin_ctz(forceBits);
+    int sj = slots[l];
+    forceBits &= forceBits - 1;
+    job.fx[sj] -= fx[l];
+    job.fy[sj] -= fy[l];
+    job.fz[sj] -= fz[l];
+  }
+  while (cohesionBits != 0) {
+    int l = __builtin_ctz(cohesionBits);
+    int j = partners[l];
+    int sj = slots[l];
+    float cohesion = job.wC * dist[l];
+    cohesionBits &= cohesionBits - 1;
+    job.neighbourVel[3 * i] += job.vx[sj];
+    job.neighbourVel[3 * i + 1] += job.vy[sj];
+    job.neighbourVel[3 * i + 2] += job.vz[sj];
+    job.neighbourVel[3 * j] += job.vx[si];
+    job.neighbourVel[3 * j + 1] += job.vy[si];
+    job.neighbourVel[3 * j + 2] += job.vz[si];
+    job.cohesionSum[i] += cohesion;
+    job.cohesionSum[j] += cohesion;
+    job.neighbourCount[i]++;
+    job.neighbourCount[j]++;
+  }
+}
+
+// Partners first..first+WIDTH, the lanes past count are boid i itself,
+// which the distance check drops
+template <int WIDTH>
+__attribute__((target("avx2"))) static int const *
+batchOf(int const *partners, int first, int count, int i, int *pad) {
+  if (count - first >= WIDTH) {
+    return partners + first;
+  }
+  for (int l = 0; l < WIDTH; l++) {
+    pad[l] = first + l < count ? partners[first + l] : i;
+  }
+  return pad;
+}
+
+__attribute__((target("avx2"))) static __m256i slots8(__m256i j) {
+  if (BOID_TILE == 0) {
+    return j;
+  }
+  __m256i tile = _mm256_srli_epi32(j, TILE_SHIFT);
+  __m256i lane = _mm256_and_si256(j, _mm256_set1_epi32(BOID_TILE - 1));
+  return _mm256_add_epi32(
+      _mm256_mullo_epi32(tile,
+                         _mm256_set1_epi32(BOID_TILE * BoidStore::NUM_COLUMNS)),
+      lane);
+}
+
+__attribute__((target("avx2"))) static float sum8(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2"))) static void
+interactPairsAvx2(PairJob const &job, int i, int const *partners, int count) {
+  enum { WIDTH = 8 };
+  int si = BoidStore::slot(i);
+  __m256 xi = _mm256_set1_ps(job.px[si]); // position of boid i
+  __m256 yi = _mm256_set1_ps(job.py[si]);
+  __m256 zi = _mm256_set1_ps(job.pz[si]);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1)); // gather every lane
+  __m256i laneBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  __m256 one = _mm256_set1_ps(1.f);
+  __m256 three = _mm256_set1_ps(3.f);
+  __m256 rA = _mm256_set1_ps(job.rA);
+  __m256 rC = _mm256_set1_ps(job.rC);
+  __m256 wA = _mm256_set1_ps(job.wA);
+  __m256 wG = _mm256_set1_ps(job.wG);
+  __m256 nearest = _mm256_set1_ps(job.nearest);
+  __m256 furthest = _mm256_set1_ps(job.furthest);
+  __m256 sumX = zero; // force on boid i
+  __m256 sumY = zero;
+  __m256 sumZ = zero;
+  alignas(32) int pad[WIDTH];
+  alignas(32) int slots[WIDTH];
+  alignas(32) float fx[WIDTH];
+  alignas(32) float fy[WIDTH];
+  alignas(32) float fz[WIDTH];
+  alignas(32) float dist[WIDTH];
+
+  for (int first = 0; first < count; first += WIDTH) {
+    int const *batch = batchOf<WIDTH>(partners, first, count, i, pad);
+    __m256i at = slots8(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(batch)));
+    // the masked gathers leave no lane undefined, which GCC warns about
+    __m256 dx = _mm256_sub_ps(xi, _mm256_mask_i32gather_ps(zero, job.px, at, all, 4));
+    __m256 dy = _mm256_sub_ps(yi, _mm256_mask_i32gather_ps(zero, job.py, at, all, 4));
+    __m256 dz = _mm256_sub_ps(zi, _mm256_mask_i32gather_ps(zero, job.pz, at, all, 4));
+    __m256 d = _mm256_sqrt_ps(_mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+        _mm256_mul_ps(dz, dz)));
+
+    __m256 inRange = _mm256_cmp_ps(d, zero, _CMP_GT_OQ);
+    inRange = _mm256_and_ps(inRange, _mm256_cmp_ps(d, nearest, _CMP_GE_OQ));
+    inRange = _mm256_and_ps(inRange, _mm256_cmp_ps(d, furthest, _CMP_LT_OQ));
+    int liveBits = _mm256_movemask_ps(inRange);
+    if (liveBits == 0) {
+      continue; // most batches of a long list are all out of range
+    }
+    liveBits = dropDead(job, batch, liveBits);
+    __m256 live = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(liveBits), laneBit), laneBit));
+    __m256 avoid = _mm256_cmp_ps(d, rA, _CMP_LT_OQ);
+    __m256 cohesion =
+        _mm256_andnot_ps(avoid, _mm256_cmp_ps(d, rC, _CMP_LT_OQ));
+    __m256 close = _mm256_cmp_ps(d, one, _CMP_LE_OQ);
+
+    // favoid: wA (1-r)^3 (3r+1), wA within 1
+    __m256 r = _mm256_div_ps(d, rA);
+    __m256 t = _mm256_sub_ps(one, r);
+    __m256 fa = _mm256_mul_ps(
+        _mm256_mul_ps(wA, _mm256_mul_ps(_mm256_mul_ps(t, t), t)),
+        _mm256_add_ps(_mm256_mul_ps(three, r), one));
+    fa = _mm256_blendv_ps(fa, wA, close);
+    // fgather: wG / d^2, wG within 1
+    __m256 fg = _mm256_mul_ps(wG, _mm256_div_ps(one, _mm256_mul_ps(d, d)));
+    fg = _mm256_blendv_ps(fg, wG, close);
+
+    // force magnitude over the distance, 0 for the lanes without a force
+    __m256 s = _mm256_blendv_ps(_mm256_sub_ps(zero, _mm256_div_ps(fg, d)),
+                                _mm256_div_ps(fa, d), avoid);
+    __m256 force = _mm256_andnot_ps(cohesion, live);
+    s = _mm256_and_ps(s, force);
+    __m256 sx = _mm256_mul_ps(s, dx);
+    __m256 sy = _mm256_mul_ps(s, dy);
+    __m256 sz = _mm256_mul_ps(s, dz);
+    sumX = _mm256_add_ps(sumX, sx);
+    sumY = _mm256_add_ps(sumY, sy);
+    sumZ = _mm256_add_ps(sumZ, sz);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(slots), at);
+    _mm256_store_ps(fx, sx);
+    _mm256_store_ps(fy, sy);
+    _mm256_store_ps(fz, sz);
+    _mm256_store_ps(dist, d);
+
+    applyLanes(job, i, si, batch, slots, _mm256_movemask_ps(force),
+               _mm256_movemask_ps(_mm256_and_ps(cohesion, live)), fx, fy, fz,
+               dist);
+  }
+  job.fx[si] += sum8(sumX);
+  job.fy[si] += sum8(sumY);
+  job.fz[si] += sum8(sumZ);
+}
+
+__attribute__((target("avx512f"))) static __m512i slots16(__m512i j) {
+  if (BOID_TILE == 0) {
+    return j;
+  }
+  __m512i tile = _mm512_maskz_srli_epi32(0xFFFF, j, TILE_SHIFT);
+  __m512i lane = _mm512_and_si512(j, _mm512_set1_epi32(BOID_TILE - 1));
+  return _mm512_add_epi32(
+      _mm512_mullo_epi32(tile,
+                         _mm512_set1_epi32(BOID_TILE * BoidStore::NUM_COLUMNS)),
+      lane);
+}
+
+__attribute__((target("avx512f"))) static float sum16(__m512 v) {
+  alignas(64) float lanes[16];
+  _mm512_store_ps(lanes, v);
+  return sum8(_mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8)));
+}
+
+__attribute__((target("avx512f"))) static void
+interactPairsAvx512(PairJob const &job, int i, int const *partners,
+                    int count) {
+  enum { WIDTH = 16 };
+  int si = BoidStore::slot(i);
+  __m512 xi = _mm512_set1_ps(job.px[si]); // position of boid i
+  __m512 yi = _mm512_set1_ps(job.py[si]);
+  __m512 zi = _mm512_set1_ps(job.pz[si]);
+  __m512 zero = _mm512_setzero_ps();
+  __m512 one = _mm512_set1_ps(1.f);
+  __m512 three = _mm512_set1_ps(3.f);
+  __m512 rA = _mm512_set1_ps(job.rA);
+  __m512 rC = _mm512_set1_ps(job.rC);
+  __m512 wA = _mm512_set1_ps(job.wA);
+  __m512 wG = _mm512_set1_ps(job.wG);
+  __m512 nearest = _mm512_set1_ps(job.nearest);
+  __m512 furthest = _mm512_set1_ps(job.furthest);
+  __m512 sumX = zero; // force on boid i
+  __m512 sumY = zero;
+  __m512 sumZ = zero;
+  alignas(64) int pad[WIDTH];
+  alignas(64) int slots[WIDTH];
+  alignas(64) float fx[WIDTH];
+  alignas(64) float fy[WIDTH];
+  alignas(64) float fz[WIDTH];
+  alignas(64) float dist[WIDTH];
+
+  for (int first = 0; first < count; first += WIDTH) {
+    int const *batch = batchOf<WIDTH>(partners, first, count, i, pad);
+    __m512i at = slots16(_mm512_loadu_si512(batch));
+    // the masked forms of the gathers and the square root leave no lane
+    // undefined, which GCC warns about
+    __m512 dx = _mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, 0xFFFF, at, job.px, 4));
+    __m512 dy = _mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, 0xFFFF, at, job.py, 4));
+    __m512 dz = _mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, 0xFFFF, at, job.pz, 4));
+    __m512 d = _mm512_maskz_sqrt_ps(0xFFFF, _mm512_add_ps(
+        _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)),
+        _mm512_mul_ps(dz, dz)));
+
+    __mmask16 live = _mm512_cmp_ps_mask(d, zero, _CMP_GT_OQ);
+    live &= _mm512_cmp_ps_mask(d, nearest, _CMP_GE_OQ);
+    live &= _mm512_cmp_ps_mask(d, furthest, _CMP_LT_OQ);
+    if (live == 0) {
+      continue; // most batches of a long list are all out of range
+    }
+    live = __mmask16(dropDead(job, batch, live));
+    __mmask16 avoid = _mm512_cmp_ps_mask(d, rA, _CMP_LT_OQ);
+    __mmask16 cohesion = ~avoid & _mm512_cmp_ps_mask(d, rC, _CMP_LT_OQ);
+    __mmask16 close = _mm512_cmp_ps_mask(d, one, _CMP_LE_OQ);
+
+    // favoid: wA (1-r)^3 (3r+1), wA within 1
+    __m512 r = _mm512_div_ps(d, rA);
+    __m512 t = _mm512_sub_ps(one, r);
+    __m512 fa = _mm512_mul_ps(
+        _mm512_mul_ps(wA, _mm512_mul_ps(_mm512_mul_ps(t, t), t)),
+        _mm512_add_ps(_mm512_mul_ps(three, r), one));
+    fa = _mm512_mask_blend_ps(close, fa, wA);
+    // fgather: wG / d^2, wG within 1
+    __m512 fg = _mm512_mul_ps(wG, _mm512_div_ps(one, _mm512_mul_ps(d, d)));
+    fg = _mm512_mask_blend_ps(close, fg, wG);
+
+    // force magnitude over the distance, 0 for the lanes without a force
+    __mmask16 force = live & ~cohesion;
+    __m512 s = _mm512_mask_blend_ps(avoid,
+                                    _mm512_sub_ps(zero, _mm512_div_ps(fg, d)),
+                                    _mm512_div_ps(fa, d));
+    s = _mm512_maskz_mov_ps(force, s);
+    __m512 sx = _mm512_mul_ps(s, dx);
+    __m512 sy = _mm512_mul_ps(s, dy);
+    __m512 sz = _mm512_mul_ps(s, dz);
+    sumX = _mm512_add_ps(sumX, sx);
+    sumY = _mm512_add_ps(sumY, sy);
+    sumZ = _mm512_add_ps(sumZ, sz);
+    _mm512_store_si512(slots, at);
+    _mm512_store_ps(fx, sx);
+    _mm512_store_ps(fy, sy);
+    _mm512_store_ps(fz, sz);
+    _mm512_store_ps(dist, d);
+
+    applyLanes(job, i, si, batch, slots, int(force), int(live & cohesion), fx,
+               fy, fz, dist);
+  }
+  job.fx[si] += sum16(sumX);
+  job.fy[si] += sum16(sumY);
+  job.fz[si] += sum16(sumZ);
+}
+#endif
+
+// One partner at a time with the same laws as the kernels, for SCALAR_PAIRS
+// and for a kernel that isn't built in
+static void interactPairsPlain(PairJob const &job, int i, int const *partners,
+                               int count) {
+  int si = BoidStore::slot(i);
+  float sumX = 0.f; // force on boid i
+  float sumY = 0.f;
+  float sumZ = 0.f;
+
+  for (int n = 0; n < count; n++) {
+    int j = partners[n];
+    int sj = BoidStore::slot(j);
+    float dx = job.px[si] - job.px[sj];
+    float dy = job.py[si] - job.py[sj];
+    float dz = job.pz[si] - job.pz[sj];
+    float d = sqrtf(dx * dx + dy * dy + dz * dz);
+    if (!(d > 0.f && d >= job.nearest && d < job.furthest) || !job.alive[j]) {
+      continue;
+    }
+
+    float s;
+    if (d < job.rA) {
+      // favoid: wA (1-r)^3 (3r+1), wA within 1
+      float r = d / job.rA;
+      float t = 1.f - r;
+      float fa = d <= 1.f ? job.wA : job.wA * (t * t * t) * (3.f * r + 1.f);
+      s = fa / d;
+    } else if (d < job.rC) {
+      float cohesion = job.wC * d;
+      job.neighbourVel[3 * i] += job.vx[sj];
+      job.neighbourVel[3 * i + 1] += job.vy[sj];
+      job.neighbourVel[3 * i + 2] += job.vz[sj];
+      job.neighbourVel[3 * j] += job.vx[si];
+      job.neighbourVel[3 * j + 1] += job.vy[si];
+      job.neighbourVel[3 * j + 2] += job.vz[si];
+      job.cohesionSum[i] += cohesion;
+      job.cohesionSum[j] += cohesion;
+      job.neighbourCount[i]++;
+      job.neighbourCount[j]++;
+      continue;
+    } else {
+      // fgather: wG / d^2, wG within 1
+      float fg = d <= 1.f ? job.wG : job.wG * (1.f / (d * d));
+      s = -(fg / d);
+    }
+    sumX += s * dx;
+    sumY += s * dy;
+    sumZ += s * dz;
+    job.fx[sj] -= s * dx;
+    job.fy[sj] -= s * dy;
+    job.fz[sj] -= s * dz;
+  }
+  job.fx[si] += sumX;
+  job.fy[si] += sumY;
+  job.fz[si] += sumZ;
+}
+
+void interactPairsBatch(PairKernel kernel, PairJob const &job, int i,
+                        int const *partners, int count) {
+#if PAIR_KERNEL_AVX
+  if (kernel == AVX512_PAIRS) {
+    interactPairsAvx512(job, i, partners, count);
+    return;
+  } else if (kernel == AVX2_PAIRS) {
+    interactPairsAvx2(job, i, partners, count);
+    return;
+  }
+#else
+  (void)kernel;
+#endif
+  interactPairsPlain(job, i, partners, count);
+}
+
+// ==========================================================================//
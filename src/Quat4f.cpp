@@ -65,14 +65,17 @@ Vec3f rotateAround(Vec3f const &vec, Vec3f const &axis, float radians) {
 }
 
 void rotateAround(Vec3f &vec, Vec3f const &axis, float radians) {
+  Vec3fA rotated(vec);
+  rotateAround(rotated, Vec3fA(axis), radians);
+  vec = rotated.toVec3f();
+}
+
+void rotateAround(Vec3fA &vec, Vec3fA const &axis, float radians) {
   radians *= 0.5;
   const float sinAngle = std::sin(radians);
   const float cosAngle = std::cos(radians);
 
-  Vec3f n(axis);
-  n.normalize();
-
-  Quat4f qAxis(cosAngle, n * sinAngle);
+  Quat4f qAxis(cosAngle, (axis.normalized() * sinAngle).toVec3f());
 
   vec = qAxis * vec;
 }
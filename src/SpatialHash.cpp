@@ -0,0 +1,136 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "SpatialHash.h"
+
+// ======================== CONSTRUCTORS ============================//
+SpatialHash::SpatialHash() {
+  m_cellSize = 1.f;
+  m_mask = 0;
+}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void SpatialHash::build(BoidStore const &boids, float cellSize) {
+  int i;
+  int numBoids = boids.size();
+  unsigned int size = 1;
+  Slot empty = {0, 0, 0, -1};
+
+  m_cellSize = cellSize > 0.f ? cellSize : 1.f;
+
+  // keep the table at most half full so probe runs stay short
+  while (size < 2u * numBoids) {
+    size *= 2;
+  }
+  m_mask = size - 1;
+  m_table.assign(size, empty);
+  m_cellSlot.clear();
+  m_cellStart.assign(1, 0);
+  // there are never more cells than boids, so these don't grow step to step
+  m_cellSlot.reserve(numBoids);
+  m_cellStart.reserve(numBoids + 1);
+  m_boidCell.resize(numBoids);
+
+  // find (or add) the cell of every boid and count how many it holds
+  for (i = 0; i < numBoids; i++) {
+    Vec3f pos = boids.position(i);
+    int x = cellCoord(pos.x());
+    int y = cellCoord(pos.y());
+    int z = cellCoord(pos.z());
+    int slot = findSlot(x, y, z);
+
+    if (m_table[slot].cell < 0) {
+      m_table[slot].x = x;
+      m_table[slot].y = y;
+      m_table[slot].z = z;
+      m_table[slot].cell = int(m_cellSlot.size());
+      m_cellSlot.push_back(slot);
+      m_cellStart.push_back(0);
+    }
+    m_boidCell[i] = m_table[slot].cell;
+    m_cellStart[m_boidCell[i] + 1]++;
+  }
+
+  // prefix sum turns the counts into where each cell starts
+  for (i = 0; i < cellCount(); i++) {
+    m_cellStart[i + 1] += m_cellStart[i];
+  }
+
+  // scatter the boids into their cells
+  m_next.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+  m_sorted.resize(numBoids);
+  m_boidSlot.resize(numBoids);
+  for (i = 0; i < numBoids; i++) {
+    m_boidSlot[i] = m_next[m_boidCell[i]]++;
+    m_sorted[m_boidSlot[i]] = i;
+  }
+}
+
+// Gives every boid in the 27 cells around boid i (including i itself).
+// These are only candidates, the caller still has to check the distance.
+void SpatialHash::neighbours(int i, vector<int> &out) const {
+  Slot const &home = m_table[m_cellSlot[m_boidCell[i]]];
+
+  out.clear();
+  for (int z = home.z - 1; z <= home.z + 1; z++) {
+    for (int y = home.y - 1; y <= home.y + 1; y++) {
+      for (int x = home.x - 1; x <= home.x + 1; x++) {
+        appendCell(x, y, z, out);
+      }
+    }
+  }
+}
+
+// Gives the boids after i in its own cell and every boid in the 13 cells
+// ahead of it, see UniformGrid
+void SpatialHash::halfShell(int i, vector<int> &out) const {
+  int cell = m_boidCell[i];
+  Slot const &home = m_table[m_cellSlot[cell]];
+
+  out.assign(m_sorted.begin() + m_boidSlot[i] + 1,
+             m_sorted.begin() + m_cellStart[cell + 1]);
+  appendCell(home.x + 1, home.y, home.z, out);
+  for (int x = home.x - 1; x <= home.x + 1; x++) {
+    appendCell(x, home.y + 1, home.z, out);
+  }
+  for (int y = home.y - 1; y <= home.y + 1; y++) {
+    for (int x = home.x - 1; x <= home.x + 1; x++) {
+      appendCell(x, y, home.z + 1, out);
+    }
+  }
+}
+
+// Adds the boids of a cell, if it holds any
+void SpatialHash::appendCell(int x, int y, int z, vector<int> &out) const {
+  int cell = m_table[findSlot(x, y, z)].cell;
+  if (cell >= 0) {
+    out.insert(out.end(), m_sorted.begin() + m_cellStart[cell],
+               m_sorted.begin() + m_cellStart[cell + 1]);
+  }
+}
+
+int SpatialHash::cellCount() const { return int(m_cellSlot.size()); }
+
+// Linear probing, returns the slot holding the cell or the empty slot
+// where it would go
+int SpatialHash::findSlot(int x, int y, int z) const {
+  unsigned int h = (unsigned(x) * 73856093u) ^ (unsigned(y) * 19349663u) ^
+                   (unsigned(z) * 83492791u);
+  unsigned int slot = h & m_mask;
+
+  while (m_table[slot].cell >= 0 &&
+         (m_table[slot].x != x || m_table[slot].y != y ||
+          m_table[slot].z != z)) {
+    slot = (slot + 1) & m_mask;
+  }
+  return int(slot);
+}
+
+int SpatialHash::cellCoord(float value) const {
+  return int(floor(value / m_cellSize));
+}
+
+// ==========================================================================//
@@ -0,0 +1,129 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "UniformGrid.h"
+
+// ======================== CONSTRUCTORS ============================//
+UniformGrid::UniformGrid() {
+  m_cellSize = 1.f;
+  m_min = 0.f;
+  m_dim = 1;
+}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+void UniformGrid::build(BoidStore const &boids, float cellSize,
+                        float edge) {
+  int i;
+  int numCells;
+
+  m_cellSize = cellSize > 0.f ? cellSize : 1.f;
+  m_min = -edge;
+  // a small radius in a big box would need too many cells, bigger cells
+  // still hold every pair within the radius
+  float cells = ceil((2.f * edge) / m_cellSize);
+  if (!(cells <= MAX_DIM)) {
+    m_cellSize = (2.f * edge) / MAX_DIM;
+    cells = MAX_DIM;
+  }
+  m_dim = max(int(cells), 1);
+  numCells = m_dim * m_dim * m_dim;
+
+  // count how many boids land in each cell
+  m_cellStart.assign(numCells + 1, 0);
+  m_boidCell.resize(boids.size());
+  for (i = 0; i < boids.size(); i++) {
+    Vec3f pos = boids.position(i);
+    int cell = (cellCoord(pos.z()) * m_dim + cellCoord(pos.y())) * m_dim +
+               cellCoord(pos.x());
+    m_boidCell[i] = cell;
+    m_cellStart[cell + 1]++;
+  }
+
+  // prefix sum turns the counts into where each cell starts
+  for (i = 0; i < numCells; i++) {
+    m_cellStart[i + 1] += m_cellStart[i];
+  }
+
+  // scatter the boids into their cells
+  m_next.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+  m_sorted.resize(boids.size());
+  m_boidSlot.resize(boids.size());
+  for (i = 0; i < boids.size(); i++) {
+    m_boidSlot[i] = m_next[m_boidCell[i]]++;
+    m_sorted[m_boidSlot[i]] = i;
+  }
+}
+
+// Gives every boid in the 27 cells around boid i (including i itself).
+// These are only candidates, the caller still has to check the distance.
+void UniformGrid::neighbours(int i, vector<int> &out) const {
+  int cell = m_boidCell[i];
+  int cx = cell % m_dim;
+  int cy = (cell / m_dim) % m_dim;
+  int cz = cell / (m_dim * m_dim);
+
+  out.clear();
+  for (int z = max(cz - 1, 0); z <= min(cz + 1, m_dim - 1); z++) {
+    for (int y = max(cy - 1, 0); y <= min(cy + 1, m_dim - 1); y++) {
+      // cells along x are next to each other, so take the whole run at once
+      int row = (z * m_dim + y) * m_dim;
+      int first = m_cellStart[row + max(cx - 1, 0)];
+      int last = m_cellStart[row + min(cx + 1, m_dim - 1) + 1];
+      out.insert(out.end(), m_sorted.begin() + first,
+                 m_sorted.begin() + last);
+    }
+  }
+}
+
+// Gives the boids after i in its own cell and every boid in the 13 cells
+// ahead of it, see the class comment
+void UniformGrid::halfShell(int i, vector<int> &out) const {
+  int cell = m_boidCell[i];
+  int cx = cell % m_dim;
+  int cy = (cell / m_dim) % m_dim;
+  int cz = cell / (m_dim * m_dim);
+
+  out.assign(m_sorted.begin() + m_boidSlot[i] + 1,
+             m_sorted.begin() + m_cellStart[cell + 1]);
+  // (+1, 0, 0)
+  appendRun(cz, cy, cx + 1, cx + 1, out);
+  // (-1..+1, +1, 0)
+  appendRun(cz, cy + 1, cx - 1, cx + 1, out);
+  // (-1..+1, -1..+1, +1)
+  for (int y = cy - 1; y <= cy + 1; y++) {
+    appendRun(cz + 1, y, cx - 1, cx + 1, out);
+  }
+}
+
+// Adds the boids in cells xFirst..xLast of a row, skipping what is outside
+// the grid
+void UniformGrid::appendRun(int z, int y, int xFirst, int xLast,
+                            vector<int> &out) const {
+  xFirst = max(xFirst, 0);
+  xLast = min(xLast, m_dim - 1);
+  if (z < 0 || z >= m_dim || y < 0 || y >= m_dim || xFirst > xLast) {
+    return;
+  }
+  int row = (z * m_dim + y) * m_dim;
+  out.insert(out.end(), m_sorted.begin() + m_cellStart[row + xFirst],
+             m_sorted.begin() + m_cellStart[row + xLast + 1]);
+}
+
+int UniformGrid::cellCount() const { return m_dim * m_dim * m_dim; }
+
+// Boids outside the box (e.g. while spawning) are put in the border cells.
+// Clamping never pulls two cells more than one apart, so no pair is missed.
+int UniformGrid::cellCoord(float value) const {
+  int c = int(floor((value - m_min) / m_cellSize));
+  if (c < 0) {
+    return 0;
+  } else if (c >= m_dim) {
+    return m_dim - 1;
+  }
+  return c;
+}
+
+// ==========================================================================//
@@ -0,0 +1,13 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "Vec3fA.h"
+
+// ========================= OPERATORS ======================================//
+std::ostream &operator<<(std::ostream &out, Vec3fA const &vec) {
+  return out << vec.toVec3f();
+}
+
+// ==========================================================================//
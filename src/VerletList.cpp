@@ -0,0 +1,83 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "VerletList.h"
+
+// ======================== CONSTRUCTORS ============================//
+VerletList::VerletList() {
+  m_skin = 0.f;
+  m_stepsReused = 0;
+  m_used = false;
+}
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+bool VerletList::needsRebuild(BoidStore const &boids) const {
+  if (boids.size() != int(m_buildPos.size())) {
+    return true;
+  }
+
+  // compare squared distances to skip the square roots
+  float limit = 0.25f * m_skin * m_skin;
+  for (int i = 0; i < boids.size(); i++) {
+    if ((boids.position(i) - m_buildPos[i]).lengthSquared() > limit) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void VerletList::build(BoidStore const &boids, float radius,
+                       float skin) {
+  float reach = radius + skin;
+
+  m_skin = skin;
+  m_stepsReused = 0;
+  m_used = false;
+  m_buildPos.resize(boids.size());
+  for (int i = 0; i < boids.size(); i++) {
+    m_buildPos[i] = boids.position(i);
+  }
+  m_hash.build(boids, reach);
+
+  m_start.resize(boids.size() + 1);
+  m_list.clear();
+  for (int i = 0; i < boids.size(); i++) {
+    m_start[i] = int(m_list.size());
+    m_hash.halfShell(i, m_candidates);
+    for (int n = 0; n < int(m_candidates.size()); n++) {
+      int j = m_candidates[n];
+      if (m_buildPos[i].distance(m_buildPos[j]) < reach) {
+        m_list.push_back(j);
+      }
+    }
+  }
+  m_start[boids.size()] = int(m_list.size());
+}
+
+// Forgets the lists, needed when the boids are renumbered
+void VerletList::clear() {
+  m_buildPos.clear();
+  m_start.clear();
+  m_list.clear();
+}
+
+// Gives the boids paired with boid i that were within radius + skin,
+// every pair is only on one of the two lists
+void VerletList::neighbours(int i, vector<int> &out) const {
+  out.assign(m_list.begin() + m_start[i], m_list.begin() + m_start[i + 1]);
+}
+
+int VerletList::stepsReused() const { return m_stepsReused; }
+
+// Called once per step that uses the lists
+void VerletList::markUsed() {
+  if (m_used) {
+    m_stepsReused++;
+  }
+  m_used = true;
+}
+
+// ==========================================================================//
@@ -0,0 +1,107 @@
+/**
+ * Author:	Manorie Vachon
+ * Course:	CPSC 587 Fundamentals of Computer Animation
+ */
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+// ======================== CONSTRUCTORS ============================//
+WorkerPool::WorkerPool() {
+  m_job = NULL;
+  m_context = NULL;
+  m_parts = 0;
+  m_generation = 0;
+  m_busy = 0;
+  m_stopping = false;
+}
+
+WorkerPool::~WorkerPool() { stop(); }
+// ==========================================================================//
+
+// ========================= OPERATORS ======================================//
+// Runs jobs on numThreads threads from now on, counting the calling one.
+// Only this starts threads, so call it while warming up.
+void WorkerPool::resize(int numThreads) {
+  numThreads = max(numThreads, 1);
+  if (numThreads == size()) {
+    return;
+  }
+  stop();
+  m_stopping = false;
+  m_workers.reserve(numThreads - 1);
+  for (int w = 1; w < numThreads; w++) {
+    m_workers.push_back(thread(&WorkerPool::work, this, w, m_generation));
+  }
+}
+
+int WorkerPool::size() const { return int(m_workers.size()) + 1; }
+
+void WorkerPool::run(Job job, void *context, int parts) {
+  if (m_workers.empty() || parts <= 1) {
+    for (int p = 0; p < parts; p++) {
+      job(context, p);
+    }
+    return;
+  }
+  {
+    unique_lock<mutex> lock(m_mutex);
+    m_job = job;
+    m_context = context;
+    m_parts = parts;
+    m_busy = int(m_workers.size());
+    m_generation++;
+  }
+  m_wake.notify_all();
+  runParts(0);
+
+  unique_lock<mutex> lock(m_mutex);
+  while (m_busy > 0) {
+    m_done.wait(lock);
+  }
+}
+
+// Ends the workers, waiting for them to finish
+void WorkerPool::stop() {
+  {
+    unique_lock<mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    m_workers[w].join();
+  }
+  m_workers.clear();
+}
+
+// seen is the last job started before this worker was
+void WorkerPool::work(int worker, int seen) {
+  while (true) {
+    {
+      unique_lock<mutex> lock(m_mutex);
+      while (!m_stopping && m_generation == seen) {
+        m_wake.wait(lock);
+      }
+      if (m_stopping) {
+        return;
+      }
+      seen = m_generation;
+    }
+    runParts(worker);
+    {
+      unique_lock<mutex> lock(m_mutex);
+      m_busy--;
+    }
+    m_done.notify_one();
+  }
+}
+
+// Thread first of the pool takes parts first, first + size(), ...
+void WorkerPool::runParts(int first) {
+  for (int p = first; p < m_parts; p += size()) {
+    m_job(m_context, p);
+  }
+}
+
+// ==========================================================================//
@@ -45,6 +45,7 @@
 #include <cmath>
 #include <chrono>
 #include <limits>
+#include <thread>
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -56,7 +57,23 @@
 #include "Mat4f.h"
 #include "OpenGLMatrixTools.h"
 #include "Camera.h"
-#include "Boid.h"
+#include "BoidStore.h"
+#include "CompactBoids.h"
+#include "UniformGrid.h"
+#include "SpatialHash.h"
+#include "VerletList.h"
+#include "Octree.h"
+#include "KdTree.h"
+#include "BarnesHut.h"
+#include "MultiLevelGrid.h"
+#include "MortonOrder.h"
+#include "CacheMissCounter.h"
+#include "PageAllocator.h"
+#include "AllocationAudit.h"
+#include "PairKernel.h"
+#include "ForceLaws.h"
+#include "Integrator.h"
+#include "BoidGeometry.h"
 
 using namespace std;
 
@@ -73,6 +90,9 @@ GLuint basicProgramID;
 // Data needed for Boid
 GLuint vaoID;
 GLuint vertBufferID;
+GLsizeiptr boidBufferBytes = 0; // size of the buffer behind vertBufferID
+GLsizei boidVertexCount = 0; // vertices in that buffer, 3 per live boid
+bool boidGeometryMapped = false; // the triangles went straight into it
 Mat4f M;
 
 // Data needed for Box
@@ -102,6 +122,8 @@ bool g_cursorLocked;
 float g_cursorX, g_cursorY;
 
 bool g_play = false;
+bool g_reload = false;
+int g_spawn = 0; // bursts of boids to add (> 0) or remove (< 0)
 
 int WIN_WIDTH = 800, WIN_HEIGHT = 600;
 int FB_WIDTH = 800, FB_HEIGHT = 600;
@@ -110,7 +132,9 @@ float WIN_NEAR = 0.01;
 float WIN_FAR = 1000;
 
 /*** Boid variables **/
-vector<Vec3f> boidGeomPoints; // Points to draw (3/boid to make a triangle)
+vector<Vec3f> boidGeomPoints; // Points to draw when the buffer can't be mapped
+int orientBoids = 0; // 1 = the triangles point where the boids are going
+vector<short> boidGeomCompact; // The same points in steps of the compact copy
 float rA = 0.f; // radius of avoidance
 float rC = 0.f; // radius of cohesion
 float rG = 0.f; // radius of gathering
@@ -119,10 +143,68 @@ float wC = 0.f; // weight of cohesion
 float wG = 0.f; // weight of gathering
 float Fmax = 0.f; // max force allowed
 float Vmax = 0.f; // max velocity allowed
+int forceLawMode = POW_LAWS; // how favoid and fgather work out their laws
+ForceLaws forceLaws;
+float paramSpread = 0.f; // how much the boids' own parameters vary (make PARAMS=1)
 int numBoids = 0; // number of boids to be in the simulation
-
-// Boid object
-Boid b;
+int poolSize = 0; // slots reserved for boids, spawning past this moves the arrays
+int spawnBurst = 10; // boids added or removed per key press
+// Frames after a start, reload or spawn in which the buffers may still grow,
+// make AUDIT=1 checks that every later frame allocates nothing
+const int WARM_UP_FRAMES = 10;
+int largePages = 0; // PageMode of the boid arrays and neighbour index
+
+// How boids find the others they interact with
+enum NeighbourSearch {
+  BRUTE_FORCE = 0, // test every pair
+  UNIFORM_GRID = 1, // only test boids in the grid cells around (half shell)
+  SPATIAL_HASH = 2, // same cells, but only the occupied ones are stored
+  VERLET_LIST = 3,  // per boid lists within rG + skin, kept for several steps
+  OCTREE = 4,       // octree that is updated as the boids move
+  NEAREST_K = 5,    // only the k nearest boids, found with a k-d tree
+  MULTI_LEVEL = 6   // fine grid for avoidance, coarse grid for the rest
+};
+int searchMode = UNIFORM_GRID;
+UniformGrid grid;
+SpatialHash hashGrid;
+VerletList verletList;
+Octree octree;
+KdTree kdTree;
+int kNearest = 7; // how many nearest boids each boid interacts with in NEAREST_K
+MultiLevelGrid multiGrid;
+int coarseEvery = 1; // steps between cohesion/gathering updates in MULTI_LEVEL
+int coarseStepsLeft = 0; // steps until the coarse forces are worked out again
+
+// Long range gathering, every boid pulls on every other one
+BarnesHut barnesHut;
+float theta = 0.f; // opening angle, 0 keeps gathering cut off at rG
+float skin = 5.f; // extra distance kept in the Verlet lists
+
+int stepCount = 0; // steps simulated so far
+string scenarioFile = "boids1.txt";
+int reorderEvery = 0; // sort the boids along a Z-curve every this many steps (0 = never)
+int missReportEvery = 0; // print cache misses per step every this many steps (0 = never)
+uint64_t missTotal = 0; // cache misses since the last report
+vector<int> boidOrder; // new order of the boids when they are sorted
+vector<pair<uint32_t, int> > mortonKeys; // where the Morton codes are sorted
+vector<int> neighbours; // candidates for the boid currently being updated
+
+// Per boid sums used while stepping
+vector<Vec3f> vNeighbours;  // summed velocity of neighbours in the cohesion band
+vector<float> cohesionSum;  // summed fcohesion of those neighbours
+vector<int> neighbourCount; // number of those neighbours
+
+// State of every boid
+BoidStore boids;
+// 16 bit copy of the positions and velocities used by the pair loop and the
+// drawing when compactState is 1
+CompactBoids compact;
+int compactState = 0;
+bool compactStale = true; // the boids changed since compact was encoded
+// Pair loop for the float state, picked at startup from what the CPU has
+PairKernel pairKernel = SCALAR_PAIRS;
+int vectorPairs = 1; // 0 = always use interactPairsFrom
+int vectorIntegration = 1; // 0 = the scalar reference of the integration
 
 // Locations of instances
 //vector<Vec3f> translations;
@@ -140,6 +222,8 @@ void generateIDs();
 void deleteIDs();
 void setupVAO();
 void loadBoidGeometryToGPU();
+void reserveBoidBuffer(GLsizeiptr bytes);
+void uploadBoidGeometry(void const *data, GLsizeiptr bytes);
 void loadBallGeometryToGPU();
 void reloadProjectionMatrix();
 void loadModelViewMatrix();
@@ -156,19 +240,35 @@ void windowMouseButtonFunc(GLFWwindow *window, int button, int action,
 void windowMouseMotionFunc(GLFWwindow *window, double x, double y);
 void windowKeyFunc(GLFWwindow *window, int key, int scancode, int action,
                    int mods);
-void animateBoid(float t);
+void animateBoid(float deltaT);
 void moveCamera();
 void reloadMVPUniform();
 void reloadColorUniform(float r, float g, float b);
 std::string GL_ERROR();
 int main(int, char **);
 
-Vec3f clamp(Vec3f f, float fmax);
-float favoid(float distance);
-float fcohesion(float distance);
+float favoid(float distance, float radius, float weight);
+float fcohesion(float distance, float weight);
+float fgather(float distance, float weight);
 float fgather(float distance);
-void keepInBounds(Boid* b);
+void buildNeighbourSearch();
+void findNeighbours(int i, vector<int> &out);
+void interactPairs(int i, vector<int> const &partners, float nearest,
+                   float furthest, BoidStore::Column forceX);
+void applyCohesion(BoidStore::Column forceX);
+float interactionRadius();
+float compactRange();
+void refreshCompact();
+void reorderBoids();
+void compactBoids();
+bool needsCompaction();
+void boidsRenumbered();
+int spawnBoid(Vec3f const &pos);
+void setBoidParams(int i);
+void despawnBoid(int i);
 void initBoids();
+void reloadScenario();
+void spawnOrDespawn(int bursts);
 void getBoidGeomPoints();
 void readFile(string filename);
 void readObj(string filename);
@@ -194,7 +294,8 @@ void displayFunc() {
   // Draw Boids, start at vertex 0, draw 3 of them (for every boid)
   // Instancing
   // glDrawArraysInstanced(GL_TRIANGLES, 0, 3, translations.size());
-  glDrawArrays(GL_TRIANGLES, 0, boidGeomPoints.size());
+  glDrawArrays(GL_TRIANGLES, 0,
+               compactState ? boidGeomCompact.size() / 3 : boidVertexCount);
   glBindVertexArray(0);
 
   // ==== DRAW ball ===== //
@@ -225,13 +326,35 @@ void loadBoidGeometryToGPU() {
   // };
 
 
+  if (compactState) {
+    uploadBoidGeometry(boidGeomCompact.data(), // pointer to 3 shorts per vertex
+                       sizeof(short) * boidGeomCompact.size()); // byte size of shorts
+    return;
+  }
+  if (boidGeometryMapped) {
+    return; // getBoidGeomPoints wrote it there already
+  }
+  uploadBoidGeometry(boidGeomPoints.data(), // pointer (Vec3f*) to contents of verts
+                     sizeof(Vec3f) * boidGeomPoints.size()); // byte size of Vec3f
+}
+
+// Binds the boid buffer, which is only made again (with room to spare) when
+// the geometry has outgrown it
+void reserveBoidBuffer(GLsizeiptr bytes) {
   glBindBuffer(GL_ARRAY_BUFFER, vertBufferID);
-  glBufferData(GL_ARRAY_BUFFER,
-        //       sizeof(boidVertices), // byte size of Vec3f
-               sizeof(Vec3f) * boidGeomPoints.size(), // byte size of Vec3f
-        //       boidVertices,      // pointer (Vec3f*) to contents of verts
-               boidGeomPoints.data(),      // pointer (Vec3f*) to contents of verts
-               GL_STATIC_DRAW);   // Usage pattern of GPU buffer
+  if (bytes > boidBufferBytes) {
+    boidBufferBytes = max(bytes, 2 * boidBufferBytes);
+    glBufferData(GL_ARRAY_BUFFER,
+                 boidBufferBytes,  // byte size of the buffer
+                 NULL,             // filled below
+                 GL_DYNAMIC_DRAW); // Usage pattern of GPU buffer
+  }
+}
+
+// Writes over the boid buffer
+void uploadBoidGeometry(void const *data, GLsizeiptr bytes) {
+  reserveBoidBuffer(bytes);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
 }
 /*
 void loadTranslationsToGPU() { // no signature currently
@@ -248,8 +371,7 @@ void loadTranslationsToGPU() { // no signature currently
 glm::vec2 translations2[100];
 int index = 0;
 GLfloat offset = 0.1f;
-Boid* boid;
-b.Boids.clear();
+boids.clear();
 
 for(GLint y = -10; y < 10; y += 2)
 {
@@ -260,8 +382,7 @@ for(GLint y = -10; y < 10; y += 2)
         translation.y = (GLfloat)y / 10.0f + offset;
         translations2[index++] = translation;
 
-        boid = new Boid(Vec3f(translation.x,translation.y,0.f));
-        b.Boids.push_back(boid);
+        boids.add(Vec3f(translation.x,translation.y,0.f));
     }
 }
 
@@ -290,14 +411,25 @@ void setupVAO() {
   // vertices of shape
   glEnableVertexAttribArray(0); // match layout # in shader
   glBindBuffer(GL_ARRAY_BUFFER, vertBufferID);
-  glVertexAttribPointer(0,        // attribute layout # above
-                        3,        // # of components (ie XYZ )
-                        GL_FLOAT, // type of components
-                        GL_FALSE, // need to be normalized?
-                        0,        // stride
-            //  instancing test          5*sizeof(GL_FLOAT),        // stride
-                        (void *)0 // array buffer offset
-                        );
+  if (compactState) {
+    // shorts are read as -1 to 1, M scales them back up to the box
+    glVertexAttribPointer(0,        // attribute layout # above
+                          3,        // # of components (ie XYZ )
+                          GL_SHORT, // type of components
+                          GL_TRUE,  // need to be normalized?
+                          0,        // stride
+                          (void *)0 // array buffer offset
+                          );
+  } else {
+    glVertexAttribPointer(0,        // attribute layout # above
+                          3,        // # of components (ie XYZ )
+                          GL_FLOAT, // type of components
+                          GL_FALSE, // need to be normalized?
+                          0,        // stride
+              //  instancing test          5*sizeof(GL_FLOAT),        // stride
+                          (void *)0 // array buffer offset
+                          );
+  }
 /* Stuff that was used to try instancing
   glEnableVertexAttribArray(1); // match layout # in shader
   glVertexAttribPointer(1,        // attribute layout # above
@@ -358,7 +490,8 @@ void reloadProjectionMatrix() {
 }
 
 void loadModelViewMatrix() {
-  M = IdentityMatrix();
+  // compact vertices are fractions of the range, not positions
+  M = compactState ? UniformScaleMatrix(compactRange()) : IdentityMatrix();
   ball_M = IdentityMatrix();
   // view doesn't change, but if it did you would use this
   V = camera.lookatMatrix();
@@ -478,98 +611,41 @@ int main(int argc, char **argv) {
   std::cout << GL_ERROR() << std::endl;
 
   // Read initial states and parameters
-  readFile("boids1.txt");
+  if (argc > 1) {
+    scenarioFile = argv[1];
+  }
+  readFile(scenarioFile);
   readObj("pokeball.obj");
+  pairKernel = bestPairKernel();
+  cout << "Pair loop: " << pairKernelName(pairKernel) << endl;
   // Initialize all the geometry, and load it once to the GPU
   init();
 
-  // Variables needed in loop
   float deltaT = 0.09f;
-  int i;
-  int j;
-  float dist; // used for distance between two boids
-  Vec3f dir; // used to hold the direction between two boids
-  Vec3f Xi; // position of boid i
-  Vec3f Xj; // position of boid j
-  Vec3f F = Vec3f(0,0,0); // force being accumulated
-  Vec3f V = Vec3f(0,0,0);
-  Vec3f vNeighbours; // velocity of all neighbours
-  Vec3f averageOfNeighbours = Vec3f(0,0,0);
-  Vec3f Vc = Vec3f(0,0,0); // used as a current velocity placeholder
-  float r = 0.f;
-  int count = 0;
-  Boid* boidi;
+  int frame = 0;
+  int steadyFrom = WARM_UP_FRAMES; // first frame that must not allocate
 
   // Main running window loop
   while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
          !glfwWindowShouldClose(window)) {
 
+    // both may grow the buffers, so the flock has to warm up again
+    if (g_reload) {
+      reloadScenario();
+      g_reload = false;
+      steadyFrom = frame + WARM_UP_FRAMES;
+    }
+    if (g_spawn != 0) {
+      spawnOrDespawn(g_spawn);
+      g_spawn = 0;
+      steadyFrom = frame + WARM_UP_FRAMES;
+    }
+    AllocationCount frameStart = allocationCount();
     if (g_play) {
-        for (i = 0; i < b.Boids.size(); i++) {
-          vNeighbours.zero();
-          count = 0;
-          // get average of boids within rC
-          for (j = i + 1; j < b.Boids.size(); j++) {
-            Xi = b.Boids[i]->getPos();
-            Xj = b.Boids[j]->getPos();
-            dist = Xi.distance(Xj); // distance between the current pair
-            if (dist > rA && dist < rC) {
-              vNeighbours = vNeighbours + b.Boids[j]->getVelocity();
-              count = count + 1;
-            }
-          }
-          // go through every pair and accumulate forces
-          for (j = i + 1; j < b.Boids.size(); j++) {
-            Xi = b.Boids[i]->getPos();
-            Xj = b.Boids[j]->getPos();
-            dist = Xi.distance(Xj); // distance between the current pair
-
-            if (dist <= 0) {
-              F.zero();
-            }
-            else {
-              dir = (Xi - Xj)/dist;
-              if (dist < rA) {
-                r = dist / rA; // try changing this
-                F = favoid(dist) * dir;
-              } else if (dist < rC) {
-                if (count > 0) {
-                  // if there are pairs within cohesion distance, use their average
-                  averageOfNeighbours = vNeighbours/count;
-                  averageOfNeighbours.normalized();
-                  Vc = (averageOfNeighbours - b.Boids[i]->getVelocity());
-                  F = fcohesion(dist) * Vc;
-                } else {
-                  F.zero(); // no one to match velocities with
-                }
-              } else if (dist < rG) {
-                F = -fgather(dist) * dir;
-              } else {
-                F.zero(); // the two boids ignore each other
-              }
-            }
-
-            b.Boids[i]->setForce(b.Boids[i]->getForce() + F); // add the total force to one boid
-            b.Boids[j]->setForce(b.Boids[j]->getForce() - F); // subtract the total force from the other
-          }
-        }
-
-        // go through every boid and update velocity and position
-        for (i = 0; i < b.Boids.size(); i++) {
-          boidi = b.Boids[i];
-          F = boidi->getForce();
-          F = clamp(F, Fmax); // change to Fmax read in
-          // integrate
-          // below, 1 is used as the mass for this simulation
-          boidi->setVelocity(boidi->getVelocity() + (F/boidi->getMass())*deltaT); // F/m*dt gives new velocity
-          V = boidi->getVelocity();
-          V = clamp(V, Vmax);
-          boidi->setVelocity(V);
-          boidi->setPos(boidi->getPos() + (V*deltaT));
-          keepInBounds(boidi);
-          boidi->resetForce();
-          // update (Mi);
-        }
+      animateBoid(deltaT);
+    } else if (boids.deadCount() > 0) {
+      // nothing to simulate this frame, a good time to close the gaps
+      compactBoids();
     }
 
     // Make geometry based on the current positions of all boids
@@ -578,140 +654,662 @@ int main(int argc, char **argv) {
     //loadBallGeometryToGPU - to use later if getting the sphere to move
 
     displayFunc();
+    if (allocationAuditOn() && frame >= steadyFrom) {
+      expectNoAllocations(frameStart, "simulating and drawing", frame);
+    }
     moveCamera();
 
     glfwSwapBuffers(window);
     glfwPollEvents();
+    frame++;
   }
 
   // clean up after loop
   deleteIDs();
+  boids.release();
 
   return 0;
 }
 
-Vec3f clamp(Vec3f f, float fmax) {
-  if (f.x() > fmax) {
-    f.x() = fmax;
-  } else if (f.x() < -fmax) {
-    f.x() = -fmax;
+void animateBoid(float deltaT) {
+  int i;
+  int k;
+  int lane;
+  float reach = interactionRadius(); // pairs further apart ignore each other
+  Vec3f F = Vec3f(0,0,0); // force being accumulated
+  static CacheMissCounter missCounter;
+
+  if (missReportEvery > 0) {
+    missCounter.start();
+  }
+
+  // both drop the dead slots, so do them before anything uses the numbers
+  if (reorderEvery > 0 && stepCount % reorderEvery == 0) {
+    reorderBoids();
+  } else if (needsCompaction()) {
+    compactBoids();
+  }
+  int boidCount = boids.size();
+  int tileCount = boids.tileCount();
+
+  boids.resetForces();
+  vNeighbours.assign(boidCount, Vec3f(0,0,0));
+  cohesionSum.assign(boidCount, 0.f);
+  neighbourCount.assign(boidCount, 0);
+  // no boid can have more candidates than there are boids, so the list
+  // never grows in the middle of a step
+  neighbours.reserve(boidCount);
+
+  buildNeighbourSearch();
+  if (compactState) {
+    refreshCompact();
+  }
+
+  if (searchMode == MULTI_LEVEL) {
+    // avoidance every step, only from the close boids on the fine level
+    for (k = 0; k < tileCount; k++) {
+      BoidStore::Tile t = boids.tile(k);
+      for (lane = 0; lane < t.count(); lane++) {
+        if (t.alive()[lane]) {
+          multiGrid.fineHalfShell(t.first() + lane, neighbours);
+          interactPairs(t.first() + lane, neighbours, 0.f, rA, BoidStore::FX);
+        }
+      }
+    }
+    // cohesion and gathering from the coarse level, when they are due
+    if (coarseStepsLeft <= 0) {
+      multiGrid.buildCoarse(boids, reach, edge);
+      boids.resetKeptForces();
+      for (k = 0; k < tileCount; k++) {
+        BoidStore::Tile t = boids.tile(k);
+        for (lane = 0; lane < t.count(); lane++) {
+          if (t.alive()[lane]) {
+            multiGrid.coarseHalfShell(t.first() + lane, neighbours);
+            interactPairs(t.first() + lane, neighbours, rA, reach,
+                          BoidStore::KEPT_FX);
+          }
+        }
+      }
+      applyCohesion(BoidStore::KEPT_FX);
+      coarseStepsLeft = max(coarseEvery, 1);
+    }
+    coarseStepsLeft--;
+    for (k = 0; k < tileCount; k++) {
+      BoidStore::Tile t = boids.tile(k);
+      float *fx = t.fx();
+      float *fy = t.fy();
+      float *fz = t.fz();
+      float const *keptFx = t.field(BoidStore::KEPT_FX);
+      float const *keptFy = t.field(BoidStore::KEPT_FY);
+      float const *keptFz = t.field(BoidStore::KEPT_FZ);
+      for (lane = 0; lane < t.count(); lane++) {
+        fx[lane] += keptFx[lane];
+        fy[lane] += keptFy[lane];
+        fz[lane] += keptFz[lane];
+      }
+    }
+  } else {
+    for (k = 0; k < tileCount; k++) {
+      BoidStore::Tile t = boids.tile(k);
+      for (lane = 0; lane < t.count(); lane++) {
+        if (t.alive()[lane]) {
+          findNeighbours(t.first() + lane, neighbours);
+          interactPairs(t.first() + lane, neighbours, 0.f, reach,
+                        BoidStore::FX);
+        }
+      }
+    }
+    applyCohesion(BoidStore::FX);
+  }
+
+  // gathering between all boids, approximated for the far away ones
+  if (theta > 0.f) {
+    barnesHut.build(boids);
+    for (k = 0; k < tileCount; k++) {
+      BoidStore::Tile t = boids.tile(k);
+      for (lane = 0; lane < t.count(); lane++) {
+        F = barnesHut.gather(t.first() + lane, theta, reach, fgather);
+#if BOID_PARAMS
+        if (wG != 0.f) {
+          F *= t.field(BoidStore::GATHER_WEIGHT)[lane] / wG;
+        }
+#endif
+        t.fx()[lane] += F.x();
+        t.fy()[lane] += F.y();
+        t.fz()[lane] += F.z();
+      }
+    }
+  }
+
+  // go through every boid and work out its next velocity and position,
+  // without tiles the columns are one run over all the boids
+  int runs = BOID_TILE == 0 ? min(tileCount, 1) : tileCount;
+  for (k = 0; k < runs; k++) {
+    BoidStore::Tile t = boids.tile(k);
+    StepRun run = {t.px(), t.py(), t.pz(), t.vx(), t.vy(), t.vz(),
+                   t.fx(), t.fy(), t.fz(), t.mass(),
+#if BOID_PARAMS
+                   t.field(BoidStore::MAX_FORCE), t.field(BoidStore::MAX_SPEED),
+#else
+                   0, 0,
+#endif
+                   t.nextPx(), t.nextPy(), t.nextPz(),
+                   t.nextVx(), t.nextVy(), t.nextVz(),
+                   BOID_TILE == 0 ? boids.size() : t.count(),
+                   Fmax, Vmax, deltaT, edge};
+    if (vectorIntegration) {
+      integrateVector(run);
+    } else {
+      integrateScalar(run);
+    }
+  }
+  boids.swap();
+  compactStale = true;
+
+  if (searchMode == OCTREE) {
+    for (i = 0; i < boidCount; i++) {
+      if (boids.isAlive(i)) {
+        octree.update(i, boids.position(i));
+      }
+    }
+  }
+
+  stepCount++;
+  if (missReportEvery > 0) {
+    missTotal += missCounter.stop();
+    if (stepCount % missReportEvery == 0) {
+      if (missCounter.available()) {
+        cout << "Cache misses per step: " << missTotal / missReportEvery
+             << endl;
+      } else {
+        cout << "Cache miss counter is not available" << endl;
+      }
+      missTotal = 0;
+    }
+  }
+}
+
+// How the pair loop reads the state of the boids: T is float for the store
+// itself, or short for the compact copy, where the scales turn steps back
+// into distances and speeds. The store is read through BoidStore::slot.
+template <typename T, bool SLOTTED>
+struct PairState {
+  T const *px;
+  T const *py;
+  T const *pz;
+  T const *vx;
+  T const *vy;
+  T const *vz;
+  float positionScale;
+  float velocityScale;
+
+  static int at(int i) { return SLOTTED ? BoidStore::slot(i) : i; }
+};
+
+// Radii and weights a pair of boids interacts with. With make PARAMS=1 they
+// are the mean of the two boids' own, so both see the pair the same way and
+// the forces stay equal and opposite, otherwise they are the scenario's.
+struct PairParams {
+  float rA, rC, rG;
+  float wA, wC, wG;
+};
+
+// Own parameters of the boid in slot s
+inline PairParams ownParams(int s) {
+#if BOID_PARAMS
+  PairParams p = {boids.column(BoidStore::AVOID_RADIUS)[s],
+                  boids.column(BoidStore::COHESION_RADIUS)[s],
+                  boids.column(BoidStore::GATHER_RADIUS)[s],
+                  boids.column(BoidStore::AVOID_WEIGHT)[s],
+                  boids.column(BoidStore::COHESION_WEIGHT)[s],
+                  boids.column(BoidStore::GATHER_WEIGHT)[s]};
+#else
+  (void)s;
+  PairParams p = {rA, rC, rG, wA, wC, wG};
+#endif
+  return p;
+}
+
+inline PairParams pairParams(PairParams const &own, int sj) {
+#if BOID_PARAMS
+  PairParams other = ownParams(sj);
+  PairParams p = {0.5f * (own.rA + other.rA), 0.5f * (own.rC + other.rC),
+                  0.5f * (own.rG + other.rG), 0.5f * (own.wA + other.wA),
+                  0.5f * (own.wC + other.wC), 0.5f * (own.wG + other.wG)};
+  return p;
+#else
+  (void)sj;
+  return own;
+#endif
+}
+
+// Goes through the pairs of boid i that are at least nearest and less than
+// furthest apart. Avoidance and gathering are added to the force arrays
+// right away, pairs in the cohesion band are only summed up for both boids.
+// Partners in dead slots are skipped.
+template <typename T, bool SLOTTED>
+void interactPairsFrom(PairState<T, SLOTTED> const &state,
+                       unsigned char const *alive, int i,
+                       vector<int> const &partners, float nearest,
+                       float furthest, float *fx, float *fy, float *fz) {
+  int ai = state.at(i);
+  int si = BoidStore::slot(i);
+  T xi = state.px[ai]; // position of boid i
+  T yi = state.py[ai];
+  T zi = state.pz[ai];
+  PairParams own = ownParams(si);
+  float s; // force magnitude divided by the distance
+
+  for (int n = 0; n < int(partners.size()); n++) {
+    int j = partners[n];
+    if (!alive[j]) {
+      continue;
+    }
+    int aj = state.at(j);
+    float dx = (xi - state.px[aj]) * state.positionScale; // direction between the two boids, unnormalized
+    float dy = (yi - state.py[aj]) * state.positionScale;
+    float dz = (zi - state.pz[aj]) * state.positionScale;
+    float dist = sqrt(dx*dx + dy*dy + dz*dz); // distance between the current pair
+
+    if (dist <= 0 || dist < nearest || dist >= furthest) {
+      continue; // the two boids ignore each other
+    }
+    int sj = BoidStore::slot(j);
+    PairParams p = pairParams(own, sj);
+    if (dist < p.rA) {
+      s = favoid(dist, p.rA, p.wA)/dist;
+    } else if (dist < p.rC) {
+      vNeighbours[i] += Vec3f(state.vx[aj], state.vy[aj], state.vz[aj]) *
+                        state.velocityScale;
+      vNeighbours[j] += Vec3f(state.vx[ai], state.vy[ai], state.vz[ai]) *
+                        state.velocityScale;
+      cohesionSum[i] += fcohesion(dist, p.wC);
+      cohesionSum[j] += fcohesion(dist, p.wC);
+      neighbourCount[i]++;
+      neighbourCount[j]++;
+      continue;
+#if BOID_PARAMS
+    } else if (dist >= p.rG) {
+      continue; // the cut off of the scenario is furthest
+#endif
+    } else {
+      s = -fgather(dist, p.wG)/dist;
+    }
+
+    // add the total force to one boid, subtract it from the other
+    fx[si] += s*dx;
+    fy[si] += s*dy;
+    fz[si] += s*dz;
+    fx[sj] -= s*dx;
+    fy[sj] -= s*dy;
+    fz[sj] -= s*dz;
   }
-  if (f.y() > fmax) {
-    f.y() = fmax;
-  } else if (f.y() < -fmax) {
-    f.y() = -fmax;
+}
+
+// Adds the forces between boid i and its partners to the columns starting
+// at forceX (FX or KEPT_FX)
+void interactPairs(int i, vector<int> const &partners, float nearest,
+                   float furthest, BoidStore::Column forceX) {
+  float *fx = boids.column(forceX);
+  float *fy = boids.column(BoidStore::Column(forceX + 1));
+  float *fz = boids.column(BoidStore::Column(forceX + 2));
+
+  if (compactState) {
+    PairState<short, false> state = {
+        compact.qx(),  compact.qy(),  compact.qz(),
+        compact.qvx(), compact.qvy(), compact.qvz(),
+        compact.positionStep(), compact.velocityStep()};
+    interactPairsFrom(state, boids.alive(), i, partners, nearest, furthest,
+                      fx, fy, fz);
+  } else if (vectorPairs && !BOID_PARAMS && forceLaws.mode() != TABLE_LAWS) {
+    PairJob job = {boids.column(BoidStore::PX), boids.column(BoidStore::PY),
+                   boids.column(BoidStore::PZ), boids.column(BoidStore::VX),
+                   boids.column(BoidStore::VY), boids.column(BoidStore::VZ),
+                   boids.alive(), fx, fy, fz, vNeighbours[0].data(),
+                   cohesionSum.data(), neighbourCount.data(),
+                   rA, rC, wA, wC, wG, nearest, furthest};
+    interactPairsBatch(pairKernel, job, i, partners.data(),
+                       int(partners.size()));
+  } else {
+    PairState<float, true> state = {
+        boids.column(BoidStore::PX), boids.column(BoidStore::PY),
+        boids.column(BoidStore::PZ), boids.column(BoidStore::VX),
+        boids.column(BoidStore::VY), boids.column(BoidStore::VZ),
+        1.f, 1.f};
+    interactPairsFrom(state, boids.alive(), i, partners, nearest, furthest,
+                      fx, fy, fz);
   }
-  if (f.z() > fmax) {
-    f.z() = fmax;
-  } else if (f.z() < -fmax) {
-    f.z() = -fmax;
+}
+
+// Matches velocities with the average of the neighbours in the cohesion band.
+// Each boid steers itself with the sum of fcohesion over all of them, there
+// is no opposite force on the neighbours (see H in the README).
+void applyCohesion(BoidStore::Column forceX) {
+  float *fx = boids.column(forceX);
+  float *fy = boids.column(BoidStore::Column(forceX + 1));
+  float *fz = boids.column(BoidStore::Column(forceX + 2));
+
+  for (int i = 0; i < boids.size(); i++) {
+    if (neighbourCount[i] > 0) {
+      Vec3f averageOfNeighbours = vNeighbours[i]/neighbourCount[i];
+      Vec3f Vc = (averageOfNeighbours - boids.velocity(i));
+      int s = BoidStore::slot(i);
+      fx[s] += cohesionSum[i] * Vc.x();
+      fy[s] += cohesionSum[i] * Vc.y();
+      fz[s] += cohesionSum[i] * Vc.z();
+    }
   }
-  return f;
 }
 
-float favoid(float distance) {
-  float r = distance / rA;
+float favoid(float distance, float radius, float weight) {
+  float r = distance / radius;
   if (distance <= 1) {
-    return wA*1.f;
+    return weight*1.f;
+  } else if (forceLaws.mode() != POW_LAWS) {
+    return weight * forceLaws.avoid(r);
   } else {
-    return wA * pow((1-r), 3) * (3*r + 1);
+    return weight * pow((1-r), 3) * (3*r + 1);
     // A different function that was used
-    //wA * (1/(pow(distance, 2))); // 1/x^2 function
+    //weight * (1/(pow(distance, 2))); // 1/x^2 function
   }                                // return force value of function
 }
 
-float fcohesion(float distance) {
-  return wC*(distance); // x function
+float fcohesion(float distance, float weight) {
+  return weight*(distance); // x function
 }              // return force value of function
 
-float fgather(float distance) {
+float fgather(float distance, float weight) {
   if (distance <= 1) {
-    return wG*1.f;
+    return weight*1.f;
+  } else if (forceLaws.mode() != POW_LAWS) {
+    return weight * forceLaws.gather(distance);
   } else {
-    return wG*(1/(pow(distance, 2))); // 1/x^2 function
+    return weight*(1/(pow(distance, 2))); // 1/x^2 function
   }                                // return force value of function
 }
 
-void keepInBounds(Boid* b) {
-  Vec3f pos = b->getPos();
-  Vec3f vel = b->getVelocity();
+// With the scenario's weight, for Barnes-Hut
+float fgather(float distance) { return fgather(distance, wG); }
+
+// Every boid is kept within edge of the origin, the triangles drawn for
+// them stick out by 1 more
+float compactRange() { return edge + 2.f; }
 
-  if (pos.x() > edge) {
-    pos.x() = edge-1;
-    vel.x() = -vel.x();
-  } else if (pos.x() < -edge) {
-    pos.x() = -(edge-1);
-    vel.x() = -vel.x();
+// Encodes the 16 bit copy if the boids changed since the last time, so the
+// drawing and the next step share one encode
+void refreshCompact() {
+  if (compactStale) {
+    compact.encode(boids, compactRange(), Vmax);
+    compactStale = false;
   }
+}
 
-  if (pos.y() > edge) {
-    pos.y() = edge-1;
-    vel.y() = -vel.y();
-  } else if (pos.y() < -edge) {
-    pos.y() = -(edge-1);
-    vel.y() = -vel.y();
+// Largest distance at which two boids still interact in the pair loop. With
+// long range gathering on, gathering is left to the Barnes-Hut tree.
+float interactionRadius() {
+  if (theta > 0.f) {
+    return max(rA, rC);
   }
+  return max(rA, max(rC, rG));
+}
 
-  if (pos.z() > edge) {
-    pos.z() = edge-1;
-    vel.z() = -vel.z();
-  } else if (pos.z() < -edge) {
-    pos.z() = -(edge-1);
-    vel.z() = -vel.z();
+// Prepares the neighbour search for the current boid positions,
+// has to be called once per step before findNeighbours
+void buildNeighbourSearch() {
+  if (searchMode == UNIFORM_GRID) {
+    // nothing interacts past this radius, so that is the cell size
+    grid.build(boids, interactionRadius(), edge);
+  } else if (searchMode == SPATIAL_HASH) {
+    hashGrid.build(boids, interactionRadius());
+  } else if (searchMode == VERLET_LIST) {
+    if (verletList.needsRebuild(boids)) {
+      if (boids.size() > 0) {
+        cout << "Verlet lists rebuilt, last ones were reused for "
+             << verletList.stepsReused() << " steps" << endl;
+      }
+      verletList.build(boids, interactionRadius(), skin);
+    }
+    verletList.markUsed();
+  } else if (searchMode == OCTREE) {
+    // only built once, after that it follows the boids as they move
+    if (!octree.isValid(boids.size())) {
+      octree.build(boids, edge);
+    }
+  } else if (searchMode == NEAREST_K) {
+    int threads = max(1, int(thread::hardware_concurrency()));
+    kdTree.build(boids, threads);
+    kdTree.buildPairs(max(kNearest, 1), threads);
+  } else if (searchMode == MULTI_LEVEL) {
+    // the coarse level is only built when it is used
+    multiGrid.buildFine(boids, rA, edge);
   }
-  b->setPos(pos);
-  b->setVelocity(vel);
+}
+
+// Gives the boids that boid i might interact with. Each pair is only given
+// for one of its two boids, which applies both +F and -F.
+void findNeighbours(int i, vector<int> &out) {
+  if (searchMode == UNIFORM_GRID) {
+    grid.halfShell(i, out);
+  } else if (searchMode == SPATIAL_HASH) {
+    hashGrid.halfShell(i, out);
+  } else if (searchMode == OCTREE) {
+    // the tree gives everyone around i, keep the boids after it
+    octree.neighbours(i, interactionRadius(), out);
+    int kept = 0;
+    for (int n = 0; n < int(out.size()); n++) {
+      if (out[n] > i) {
+        out[kept++] = out[n];
+      }
+    }
+    out.resize(kept);
+  } else if (searchMode == VERLET_LIST) {
+    verletList.neighbours(i, out);
+  } else if (searchMode == NEAREST_K) {
+    kdTree.neighbours(i, out);
+  } else {
+    out.clear();
+    for (int j = i + 1; j < boids.size(); j++) {
+      out.push_back(j);
+    }
+  }
+}
+
+// Sorts the boids by the Morton code of their grid cell, so boids that are
+// close in space are also close in memory while the pairs are processed
+void reorderBoids() {
+  mortonOrder(boids, interactionRadius(), edge, boidOrder, mortonKeys);
+  boids.permute(boidOrder.data(), int(boidOrder.size()));
+  boidsRenumbered();
+}
+
+// Moves the live boids down over the dead slots
+void compactBoids() {
+  boids.compact(boidOrder);
+  boidsRenumbered();
+}
+
+// The pair loops skip dead slots, but the k-d tree and Barnes-Hut would
+// count them, and too many make the skipping itself slow
+bool needsCompaction() {
+  if (boids.deadCount() == 0) {
+    return false;
+  }
+  return searchMode == NEAREST_K || theta > 0.f ||
+         4 * boids.deadCount() > boids.size();
+}
+
+// Has to be called whenever the boids change slots
+void boidsRenumbered() {
+  // the lists, the tree and the kept forces use the old boid numbers
+  verletList.clear();
+  octree.clear();
+  coarseStepsLeft = 0;
+  compactStale = true;
+}
+
+// Adds a boid at rest at pos, returns its slot
+int spawnBoid(Vec3f const &pos) {
+  int i = boids.add(pos);
+  setBoidParams(i);
+  // a reused slot is still filed where its last boid was
+  octree.update(i, pos);
+  // the kept coarse forces belong to whoever had the slot before
+  coarseStepsLeft = 0;
+  compactStale = true;
+  return i;
+}
+
+// Gives boid i its own parameters (make PARAMS=1): a size between 1-Z and 1
+// that its radii are scaled by and a stamina in the same range for its max
+// force and speed. Both are at most 1, so the neighbour searches sized for
+// the scenario's radii still find every pair.
+void setBoidParams(int i) {
+#if BOID_PARAMS
+  float size = 1.f;
+  float stamina = 1.f;
+  if (paramSpread > 0.f) {
+    size -= paramSpread * (rand() / float(RAND_MAX));
+    stamina -= paramSpread * (rand() / float(RAND_MAX));
+  }
+  float values[] = {rA * size, rC * size, rG * size, wA, wC, wG,
+                    Fmax * stamina, Vmax * stamina};
+  int s = BoidStore::slot(i);
+  for (int c = 0; c < 8; c++) {
+    boids.column(BoidStore::Column(BoidStore::AVOID_RADIUS + c))[s] = values[c];
+  }
+#else
+  (void)i;
+#endif
+}
+
+// Takes boid i out of the flock, its slot is reused by the next spawn
+void despawnBoid(int i) {
+  boids.remove(i);
+  octree.erase(i);
+  coarseStepsLeft = 0;
 }
 
 void initBoids() {
-  Boid* boid;
   float spawn = edge -2;
   float x = -spawn;
   float y = spawn;
   float z = 0.f;
 
+  if (PageMode(largePages) != pageMode()) {
+    // the kept blocks are on the old pages
+    boids.release();
+  }
+  setPageMode(PageMode(largePages));
+  size_t fallbacks = pageFallbacks();
+
+  boids.clear();
+  boids.reserve(max(numBoids, poolSize));
+  compactStale = true;
+  if (pageFallbacks() > fallbacks) {
+    cout << "Huge pages are not available, using normal pages" << endl;
+  }
+  forceLaws.build(ForceLawMode(forceLawMode), max(rC, rG));
+  if (forceLaws.mode() != POW_LAWS) {
+    cout << "Force laws from "
+         << (forceLaws.mode() == TABLE_LAWS ? "tables" : "polynomials")
+         << ", largest error avoidance " << forceLaws.avoidError()
+         << ", gathering " << forceLaws.gatherError() << " of the weight"
+         << endl;
+  }
+  if (paramSpread > 0.f && !BOID_PARAMS) {
+    cout << "Z needs the boids' own parameters, build with make PARAMS=1" << endl;
+  }
   for (int i = 0; i < numBoids; i++) {
-    boid = new Boid(Vec3f(x,y,z));
-    b.Boids.push_back(boid);
+    spawnBoid(Vec3f(x,y,z));
     x = x + 5.f;
     if (x >= spawn) { // put on the next row down
       x = -spawn;
       y = y - 5.f;
     }
   }
+}
+
+// Starts the flock over from the scenario file. The boids reuse the memory
+// of the last flock, so nothing is allocated unless the flock got bigger.
+void reloadScenario() {
+  verletList.clear();
+  octree.clear();
+  coarseStepsLeft = 0;
+  stepCount = 0;
+  readFile(scenarioFile);
+  initBoids();
+  // the vertex format and scale depend on compactState
+  setupVAO();
+  loadModelViewMatrix();
+}
 
-  for (int i = 0; i < b.Boids.size(); i++) {
-    // get average of boids within rC
-    for (int j = i + 1; j < b.Boids.size(); j++) {
-      Vec3f Xi = b.Boids[i]->getPos();
-      Vec3f Xj = b.Boids[j]->getPos();
-      float dist = Xi.distance(Xj); // distance between the current pair
+// Adds spawnBurst boids at the centre of the box for every burst, or
+// removes that many random boids when bursts is negative
+void spawnOrDespawn(int bursts) {
+  for (int n = 0; n < bursts * spawnBurst; n++) {
+    spawnBoid(Vec3f(rand() % 5 - 2.f, rand() % 5 - 2.f, rand() % 5 - 2.f));
+  }
+  for (int n = 0; n < -bursts * spawnBurst && boids.liveCount() > 0; n++) {
+    int i = rand() % boids.size();
+    while (!boids.isAlive(i)) {
+      i = (i + 1) % boids.size();
     }
+    despawnBoid(i);
   }
 }
 
+// Writes the triangles straight into the mapped GL buffer, or into the
+// vector, which keeps its size from the frame before, when the buffer can't
+// be mapped. Neither allocates in a frame.
 void getBoidGeomPoints() {
-  boidGeomPoints.clear();
-  Vec3f boidPos;
-  Vec3f vel;
-
-  for (int i = 0; i < b.Boids.size(); i++) {
-    boidPos = b.Boids[i]->getPos();
-    vel = b.Boids[i]->getVelocity();
+  if (compactState) {
+    refreshCompact();
+    compact.geometry(boids.alive(), boidGeomCompact);
+    return;
+  }
 
-    boidGeomPoints.push_back(Vec3f(boidPos.x()-0.5f, boidPos.y(), boidPos.z()));
-    boidGeomPoints.push_back(Vec3f(boidPos.x()+1.f, boidPos.y()+0.5f, boidPos.z()));
-    boidGeomPoints.push_back(Vec3f(boidPos.x()+1.f, boidPos.y()-0.5f, boidPos.z()));
-    // Push the nose (x position) out 0.5 to the left (x-0.5),
-    // and the tail points 1 back (x+1) and 0.5 up (y+0.5) and
-    // down (y-0.5), respectively
+  int live = boids.liveCount();
+  GLsizeiptr bytes = GLsizeiptr(sizeof(Vec3f)) * 3 * live;
+  void *mapped = NULL;
+  if (live > 0) {
+    reserveBoidBuffer(bytes);
+    mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  }
+  boidGeometryMapped = mapped != NULL;
+  if (boidGeometryMapped) {
+    boidVertexCount = 3 * boidTriangles(boids, static_cast<float *>(mapped),
+                                        orientBoids);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    return;
   }
+  boidGeomPoints.resize(3 * live);
+  float *out = live > 0 ? boidGeomPoints[0].data() : NULL;
+  boidVertexCount = 3 * boidTriangles(boids, out, orientBoids);
 }
 
 void readFile(string filename) {
   ifstream file(filename);
   char input;
 
+  // a file that leaves an optional key out gets its default, not what the
+  // file read before set
+  searchMode = UNIFORM_GRID;
+  skin = 5.f;
+  reorderEvery = 0;
+  missReportEvery = 0;
+  kNearest = 7;
+  theta = 0.f;
+  coarseEvery = 1;
+  compactState = 0;
+  poolSize = 0;
+  largePages = 0;
+  paramSpread = 0.f;
+  vectorPairs = 1;
+  forceLawMode = POW_LAWS;
+  vectorIntegration = 1;
+  orientBoids = 0;
+
   if (file.is_open()) {
     file >> input;
 
@@ -736,6 +1334,36 @@ void readFile(string filename) {
           file >> wG;
       } else if(input == 'E') {
           file >> edge;
+      } else if(input == 'S') {
+          file >> searchMode;
+      } else if(input == 'R') {
+          file >> skin;
+      } else if(input == 'O') {
+          file >> reorderEvery;
+      } else if(input == 'M') {
+          file >> missReportEvery;
+      } else if(input == 'K') {
+          file >> kNearest;
+      } else if(input == 'B') {
+          file >> theta;
+      } else if(input == 'U') {
+          file >> coarseEvery;
+      } else if(input == 'Q') {
+          file >> compactState;
+      } else if(input == 'P') {
+          file >> poolSize;
+      } else if(input == 'L') {
+          file >> largePages;
+      } else if(input == 'Z') {
+          file >> paramSpread;
+      } else if(input == 'X') {
+          file >> vectorPairs;
+      } else if(input == 'W') {
+          file >> forceLawMode;
+      } else if(input == 'I') {
+          file >> vectorIntegration;
+      } else if(input == 'Y') {
+          file >> orientBoids;
       }
       file >> input;
     }
@@ -866,6 +1494,15 @@ void windowKeyFunc(GLFWwindow *window, int key, int scancode, int action,
   case GLFW_KEY_SPACE:
     g_play = set ? !g_play : g_play;
     break;
+  case GLFW_KEY_R:
+    g_reload = g_reload || action == GLFW_PRESS;
+    break;
+  case GLFW_KEY_EQUAL:
+    g_spawn += action == GLFW_PRESS ? 1 : 0;
+    break;
+  case GLFW_KEY_MINUS:
+    g_spawn -= action == GLFW_PRESS ? 1 : 0;
+    break;
   case GLFW_KEY_LEFT_BRACKET:
     if (mods == GLFW_MOD_SHIFT) {
       g_rotationSpeed *= 0.5;